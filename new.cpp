@@ -1,391 +1,6877 @@
-#include <string>
-#include <vector>
-#include <unordered_map>
-#include <mutex>
-#include <shared_mutex>
-#include <set>
-
-bool clockState = false;
-
-void tick() {
-	clockState = !clockState;
-}
-
-
-std::shared_mutex neuronMapMutex;
-std::unordered_map<std::string, std::unique_ptr<Neuron>> neuronMap;
-
-enum class NeuronType { generic, reward, input, output };
-
-
-struct cellPosition {
-	long x, y, z;
-};
-
-struct neuronPosition {
-	cellPosition Position;
-	std::string hash;
-};
-
-void pushToNeuron(std::string hash, int strength) {
-	std::shared_lock<std::shared_mutex> lock(neuronMapMutex);
-
-	auto it = neuronMap.find(hash);  // Check existence AFTER locking
-	if (it == neuronMap.end()) {
-		return;  // Prevents access to a deleted entry
-	}
-	Neuron& c = *(it->second);
-	if (auto* neuron = dynamic_cast<NeuronWithParents*>(&c)) {
-		neuron->wakeNeuron(strength);
-	}
-}
-
-struct Synapse {
-
-	std::string parentNeuronHash;
-	std::string childNeuronHash;
-	//manually set neuron strength to 100 when setting up base netowrk synapses
-	//cap total value at maybe 1000
-	int strength = 1;
-
-	std::mutex chargeMute;
-	void chargeSynapse() {
-		std::lock_guard<std::mutex> lock(chargeMute);
-		std::thread t(pushToNeuron, childNeuronHash, strength);
-		t.detach();
-	}
-
-	int age = 0;
-
-	void rewardSynapse(bool reward, const int& amount) {
-		std::lock_guard<std::mutex> lock(chargeMute);
-		
-		int ageMultiplyer = 0;
-
-		//young synapses should respond more strongly to feedback
-		//older neurons will benefit from more stability
-
-		if (age < 5) {
-			ageMultiplyer = 20;
-		}
-		else if (age < 20) {
-			ageMultiplyer = 5;
-		}
-		else if (age < 100) {
-			ageMultiplyer = 2;
-		}
-
-		if (strength < 0) {
-			reward = !reward;
-		}
-		if (reward) {
-			strength += (amount * ageMultiplyer);
-			if (strength > 1000) {
-				strength = 1000;
-			}
-		}
-		else {
-			strength -= (amount * ageMultiplyer);
-			if (strength < -1000) {
-				strength = -1000;
-			}
-		}
-		age++;
-	}
-
-};
-
-std::string computeSynapsePositionHash(const cellPosition& parentNeuron, const cellPosition& childNeuron) {
-	std::string holder = "";
-	holder += std::to_string(parentNeuron.x);
-	holder += std::to_string(parentNeuron.y);
-	holder += std::to_string(parentNeuron.z);
-	holder += std::to_string(childNeuron.x);
-	holder += std::to_string(childNeuron.y);
-	holder += std::to_string(childNeuron.z);
-	return holder;
-}
-
-std::shared_mutex synapseMapMutex;
-std::unordered_map<std::string, std::unique_ptr<Synapse>> synapseMap;
-
-void createSynapse(const cellPosition& parentNeuron, const std::string& parentHash,
-	const cellPosition& childNeuron, const std::string& childHash) {
-
-	std::string newHash = computeSynapsePositionHash(parentNeuron, childNeuron);
-
-	std::unique_ptr<Synapse> newSynapse = std::make_unique<Synapse>();
-
-	newSynapse->parentNeuronHash = parentHash;
-	newSynapse->childNeuronHash = childHash;
-
-	{
-		std::unique_lock<std::shared_mutex> lock(synapseMapMutex);
-		synapseMap[newHash] = std::move(newSynapse);
-	}
-
-	std::shared_lock<std::shared_mutex> lock(neuronMapMutex);
-	Neuron& p = *neuronMap[parentHash];
-	if (auto* ThisParentNeuron = dynamic_cast<NeuronWithChildren*>(&p)) {
-		ThisParentNeuron->appendChildHash(newHash);
-	}
-	Neuron& c = *neuronMap[childHash];
-	if (auto* ThisChildNeuron = dynamic_cast<NeuronWithParents*>(&c)) {
-		ThisChildNeuron->appendParentHash(newHash);
-	}
-}
-
-std::mutex occupiedPositionsMute;
-std::set<cellPosition> occupiedCellPositions;
-
-bool cellPosOccupied(const cellPosition& pos) {
-	return occupiedCellPositions.find(pos) != occupiedCellPositions.end();
-}
-
-std::string computeNeuronPositionHash(const cellPosition& pos) {
-	std::string holder = "";
-	holder += std::to_string(pos.x);
-	holder += std::to_string(pos.y);
-	holder += std::to_string(pos.z);
-	return holder;
-}
-
-void createNeuron(cellPosition pos, NeuronType type) {
-
-	static bool rewardNeuronExists = false;
-
-	if (type == NeuronType::reward) {
-		if (rewardNeuronExists) {
-			return;
-		}
-		else {
-			rewardNeuronExists = true;
-		}
-	}
-
-	if (type == NeuronType::generic) {
-
-		std::lock_guard<std::mutex> lock(occupiedPositionsMute);
-		if (cellPosOccupied(pos)) {
-			return;
-		}
-		occupiedCellPositions.insert(pos);
-		
-		std::string newHash = computeNeuronPositionHash(pos);
-		std::unique_ptr<Neuron> newNeuron = std::make_unique<GenericNeuron>();
-
-		newNeuron->positionData = { pos, newHash };
-
-		std::unique_lock<std::shared_mutex> lock(neuronMapMutex);
-		neuronMap.try_emplace(newHash, std::move(newNeuron));
-
-	}
-}
-
-
-float calculateInput(const int& strength) {
-	//neuron output is 30 in all cases, synapse strngth varies
-	return 30 * (strength * 0.1f);
-}
-
-class Neuron {
-public:
-	virtual ~Neuron() = default;
-	neuronPosition positionData;
-
-	virtual void fire() = 0;
-
-	
-
-};
-
-class NeuronWithParents : virtual public Neuron {
-public:
-
-	int input = 0;
-	float neuronCharge = -65;
-	int fireThreshold = -55;
-	
-	std::mutex wakeMute;
-	virtual void wakeNeuron(const int& strength) {
-		std::lock_guard<std::mutex> lock(wakeMute);
-		input += calculateInput(strength);
-		if (input > fireThreshold) {
-			fire();
-		}
-	}
-	
-	std::vector<std::string> parentSynapseHashes;
-	std::mutex parentHashListMute;
-	
-	void appendParentHash(const std::string& hash) {
-		std::lock_guard<std::mutex> lock(parentHashListMute);
-		parentSynapseHashes.push_back(hash);
-	}
-
-	void removeParentHash(const std::string& hash) {
-		std::lock_guard<std::mutex> lock(parentHashListMute);
-		parentSynapseHashes.erase(
-			std::remove(parentSynapseHashes.begin(), parentSynapseHashes.end(), hash),
-			parentSynapseHashes.end()
-		);
-	}
-
-};
-
-void pushSynapseCharge(std::string hash) {
-	std::shared_lock<std::shared_mutex> lock(synapseMapMutex);
-
-	auto it = synapseMap.find(hash);
-	if (it == synapseMap.end()) {
-		return;
-	}
-
-	Synapse& s = *(it->second);
-	s.chargeSynapse();
-}
-
-class NeuronWithChildren : virtual public Neuron {
-public:
-	std::mutex childHashListMute;
-	std::vector<std::string> childSynapseHashes;
-
-	void appendChildHash(const std::string& hash) {
-			std::lock_guard<std::mutex> lock(childHashListMute);
-			childSynapseHashes.push_back(hash);
-	}
-
-	void removeChildHash(const std::string& hash) {
-			std::lock_guard<std::mutex> lock(childHashListMute);
-			childSynapseHashes.erase(
-				std::remove(childSynapseHashes.begin(), childSynapseHashes.end(), hash),
-				childSynapseHashes.end()
-			);
-	}
-
-	void chargeChildSynapses() {
-
-		std::vector<std::string> out;
-		{
-			std::lock_guard<std::mutex> lock(childHashListMute);
-			out = childSynapseHashes;
-		}
-
-		for (const std::string& synapseHash : out) {
-			std::thread t(pushSynapseCharge, synapseHash);
-			t.detach();
-		}
-	}
-
-};
-
-void adjustThreshold(int& i, const int& fireThreshold, const std::vector<std::string>& parentHashes) {
-	//subject to change
-	i = fireThreshold + parentHashes.size();
-}
-
-class GenericNeuron : public NeuronWithParents, public NeuronWithChildren {
-
-	std::mutex firingMute;
-	bool counting = true;
-
-	void countRecovery(bool& prevState, int& neuroCharge, bool& caFire,
-	int& exhaustLevel, int& in) {
-
-		bool run = true;
-		while (run) {
-
-			if (prevState != clockState) {
-
-				std::lock_guard<std::mutex> lock(firingMute);
-
-				prevState = clockState;
-
-				if (in > 0) {
-					if (in >= 2) {
-						in -= 2;
-					}
-					else if (in < 2) {
-						in = 0;
-					}
-				}
-
-				if (neuronCharge < -67) {
-					neuronCharge += 2;
-				}
-				else if (neuronCharge > -63) {
-					neuronCharge -= 2;
-				}
-				else {
-					neuronCharge = -65;
-				}
-				if (neuronCharge == -65) {
-					caFire = true;
-					exhaustLevel = 0;
-					run = false;
-					counting = false;
-				}
-			}
-			std::this_thread::sleep_for(std::chrono::milliseconds(1));
-		}
-	}
-
-	bool previousclockState = false;
-
-	bool canFire = true;
-	int exhaustionLevel = 0;
-
-	void fire() {
-
-		if (canFire) {
-			std::lock_guard<std::mutex> lock(firingMute);
-			if (input > 95) {
-				input -= 95;
-			}
-			else {
-				input = 0;
-			};
-			chargeChildSynapses();
-			
-			bool shouldCount = false;
-
-			if (neuronCharge == -65) {
-				neuronCharge = -80;
-				exhaustionLevel = 1;
-			}
-			else {
-				neuronCharge = -(80 + exhaustionLevel);
-				exhaustionLevel++;
-				if (!counting) {
-					shouldCount = true;
-				}
-			}
-			if (neuronCharge < -90) {
-				canFire = false;
-			}
-			if (shouldCount) {
-				counting = true;
-				std::thread t(&GenericNeuron::countRecovery, this, 
-					std::ref(previousclockState), std::ref(neuronCharge), 
-					std::ref(canFire), std::ref(exhaustionLevel), std::ref(input));
-				t.detach();
-			}
-		}
-	}
-
-	void wakeNeuron(const int& strength) {
-		std::lock_guard<std::mutex> lock(wakeMute);
-		input += calculateInput(strength);
-		int adjustedThreshold;
-		std::vector<std::string> in;
-		{
-			std::lock_guard<std::mutex> lock(parentHashListMute);
-			in = parentSynapseHashes;
-		}
-		adjustThreshold(adjustedThreshold, fireThreshold, in);
-		if (adjustedThreshold > fireThreshold) {
-			fire();
-		}
-	}
-
-};
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <mutex>
+#include <shared_mutex>
+#include <set>
+#include <cstdint>
+#include <cstdlib>
+#include <algorithm>
+#include <unordered_set>
+#include <thread>
+#include <chrono>
+#include <atomic>
+#include <memory>
+#include <new>
+#include <cstdio>
+#include <type_traits>
+#include <condition_variable>
+#include <functional>
+#include <limits>
+#include <cstring>
+#include <cerrno>
+#include <iterator>
+#include <map>
+#include <cmath>
+#include <deque>
+#include <cctype>
+#include <exception>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+#include "placementSearch.h"
+#include "randomStream.h"
+
+bool clockState = false;
+uint64_t tickCount = 0;
+
+//deterministic mode delivers each tick's spikes in a canonical order
+//and seeds all randomness from globalSeed,
+//so two runs with the same seed and inputs produce the same spike trains
+bool deterministicMode = false;
+uint64_t globalSeed = 0;
+
+//periodic removal of dead synapses, see pruneSynapses
+struct pruneSettings {
+	uint64_t interval = 0;		//ticks between passes, 0 disables pruning
+	int weakStrength = 2;		//abs(strength) at or below this counts as near zero
+	int minWeakAge = 5;			//strength updates a synapse must have had before it can be pruned as weak,
+								//new synapses start at strength 1 and would otherwise go on the first passes
+	//sweep counters are 4 bits in the packed synapse, keep both limits below 15
+	int maxWeakSweeps = 5;		//passes a synapse may stay near zero before removal
+	int maxIdleSweeps = 10;		//passes without a charge before removal (maxIdleSweeps * interval ticks)
+	unsigned threads = 0;		//maintenance worker threads, read on the first pass, 0 for one per core besides the caller
+};
+
+pruneSettings pruning;
+
+//co-activity driven neuron growth, see growthEngine
+struct growthSettings {
+	uint64_t interval = 0;			//ticks between passes, 0 disables growth
+	int minCoFires = 5;				//same tick fires in one window before a pair counts as strong
+	int minDistance = 2;			//pairs closer than this have no room between them
+	int maxDistance = 4;			//chebyshev distance, pairs further apart are never compared
+	size_t maxNewNeurons = 8;		//per pass
+	int initialStrength = 10;		//0.10 of a base network synapse at 100
+};
+
+growthSettings growth;
+
+//passes that came due while maintenance was deferred, run on the first tick that isn't.
+//network state rather than tick locals, releaseNetwork clears it with the rest
+struct maintenanceState {
+	bool pruneDue = false;
+	bool growthDue = false;
+};
+
+maintenanceState maintenance;
+
+//spike timing plasticity, applied while queued spikes are delivered, see applyTimingPlasticity
+struct plasticitySettings {
+	bool enabled = false;
+	uint32_t window = 20;		//ticks, pairings further apart than this do nothing
+	int potentiation = 4;		//strength change for a pairing one tick apart, fades to 0 over the window
+	int depression = 3;
+};
+
+plasticitySettings plasticity;
+
+//set while the real-time runner is shedding load, plasticity, pruning and growth wait until it clears
+bool deferMaintenance = false;
+
+//typed slab allocator
+//objects live in fixed size slabs that never move, so a handle (or a raw pointer) stays valid
+//until the object is released. freed slots go on a free list and are reused before a new slab is cut.
+//each slot carries an 8 bit generation (odd while live) so stale handles can be detected
+//without growing the object itself. it wraps after 128 reuses of a slot, so a handle that old
+//can validate again, hold handles across a few releases at most, not indefinitely.
+//generations are atomic so isLive/forEach can run beside create/release on other threads
+struct poolHandle {
+	uint32_t index = 0;
+	uint8_t generation = 0;
+};
+
+template <typename T, uint32_t slabBits = 14>
+class slabPool {
+public:
+	static constexpr uint32_t slabSize = 1u << slabBits;
+	static constexpr uint32_t maxSlabs = (1u << 29) >> slabBits;
+
+	slabPool() : slabs(new std::atomic<slab*>[maxSlabs]) {
+		for (uint32_t i = 0; i < maxSlabs; i++) {
+			slabs[i].store(nullptr, std::memory_order_relaxed);
+		}
+	}
+
+	~slabPool() {
+		clear();
+		for (uint32_t i = 0; i < slabCount; i++) {
+			delete slabs[i].load(std::memory_order_relaxed);
+		}
+	}
+
+	slabPool(const slabPool&) = delete;
+	slabPool& operator=(const slabPool&) = delete;
+
+	template <typename... Args>
+	poolHandle create(Args&&... args) {
+		std::lock_guard<std::mutex> lock(poolMute);
+
+		uint32_t index;
+		if (!freeList.empty()) {
+			index = freeList.back();
+			freeList.pop_back();
+		}
+		else {
+			if (highWater == slabCount * slabSize) {
+				slabs[slabCount].store(new slab(), std::memory_order_release);
+				slabCount++;
+			}
+			index = highWater++;
+		}
+
+		slab& s = slabFor(index);
+		uint32_t offset = index & (slabSize - 1);
+		new (&s.objects[offset * sizeof(T)]) T(std::forward<Args>(args)...);
+		//release order publishes the constructed object to readers that see it live
+		uint8_t generation = static_cast<uint8_t>(s.generations[offset].load(std::memory_order_relaxed) + 1);
+		s.generations[offset].store(generation, std::memory_order_release);
+		live++;
+
+		return { index, generation };
+	}
+
+	void release(uint32_t index) {
+		std::lock_guard<std::mutex> lock(poolMute);
+		if (!isLive(index)) {
+			return;
+		}
+		slab& s = slabFor(index);
+		uint32_t offset = index & (slabSize - 1);
+		s.generations[offset].fetch_add(1, std::memory_order_release);
+		at(index).~T();
+		freeList.push_back(index);
+		live--;
+	}
+
+	void release(const poolHandle& h) {
+		if (valid(h)) {
+			release(h.index);
+		}
+	}
+
+	//bulk release, destroys every live object but keeps the slabs for reuse
+	void clear() {
+		std::lock_guard<std::mutex> lock(poolMute);
+		for (uint32_t index = 0; index < highWater; index++) {
+			if (isLive(index)) {
+				slabFor(index).generations[index & (slabSize - 1)].fetch_add(1, std::memory_order_release);
+				at(index).~T();
+			}
+		}
+		freeList.clear();
+		//hand out low indices first again
+		for (uint32_t index = highWater; index > 0; index--) {
+			freeList.push_back(index - 1);
+		}
+		live = 0;
+	}
+
+	T& at(uint32_t index) {
+		slab& s = slabFor(index);
+		return *std::launder(reinterpret_cast<T*>(&s.objects[(index & (slabSize - 1)) * sizeof(T)]));
+	}
+
+	bool isLive(uint32_t index) const {
+		if (index >= highWater) {
+			return false;
+		}
+		return (slabFor(index).generations[index & (slabSize - 1)].load(std::memory_order_acquire) & 1) != 0;
+	}
+
+	bool valid(const poolHandle& h) const {
+		return isLive(h.index) && slabFor(h.index).generations[h.index & (slabSize - 1)].load(std::memory_order_acquire) == h.generation;
+	}
+
+	T* get(const poolHandle& h) {
+		return valid(h) ? &at(h.index) : nullptr;
+	}
+
+	template <typename F>
+	void forEach(F&& f) {
+		for (uint32_t index = 0; index < highWater; index++) {
+			if (isLive(index)) {
+				f(index, at(index));
+			}
+		}
+	}
+
+	uint32_t indexLimit() const { return highWater; }
+	size_t liveCount() const { return live; }
+	size_t bytesReserved() const {
+		return static_cast<size_t>(slabCount) * sizeof(slab) +
+			maxSlabs * sizeof(std::atomic<slab*>) + freeList.capacity() * sizeof(uint32_t);
+	}
+
+private:
+	struct slab {
+		alignas(T) unsigned char objects[slabSize * sizeof(T)];
+		std::atomic<uint8_t> generations[slabSize] = {};
+	};
+
+	slab& slabFor(uint32_t index) const {
+		return *slabs[index >> slabBits].load(std::memory_order_acquire);
+	}
+
+	std::mutex poolMute;
+	std::unique_ptr<std::atomic<slab*>[]> slabs;
+	uint32_t slabCount = 0;
+	std::atomic<uint32_t> highWater{ 0 };
+	size_t live = 0;
+	std::vector<uint32_t> freeList;
+};
+
+enum class NeuronType { generic, reward, input, output };
+
+struct cellPosition {
+	long x, y, z;
+
+	bool operator<(const cellPosition& other) const {
+		if (x != other.x) return x < other.x;
+		if (y != other.y) return y < other.y;
+		return z < other.z;
+	}
+};
+
+struct neuronPosition {
+	cellPosition Position;
+	std::string hash;
+};
+
+//neurons are referred to by a packed 32 bit ref, top 3 bits are the NeuronType, the rest the pool index
+constexpr uint32_t neuronRefIndexBits = 29;
+constexpr uint32_t neuronRefIndexMask = (1u << neuronRefIndexBits) - 1;
+
+uint32_t makeNeuronRef(NeuronType type, uint32_t index) {
+	return (static_cast<uint32_t>(type) << neuronRefIndexBits) | (index & neuronRefIndexMask);
+}
+
+NeuronType neuronRefType(uint32_t ref) {
+	return static_cast<NeuronType>(ref >> neuronRefIndexBits);
+}
+
+uint32_t neuronRefIndex(uint32_t ref) {
+	return ref & neuronRefIndexMask;
+}
+
+//set by validateFixedPoint to run the brain on the float formula below, as the reference the
+//integer engines are measured against. off everywhere else
+bool floatInputReference = false;
+
+int calculateInput(const int& strength) {
+	//neuron output is 30 in all cases, synapse strngth varies in tenths.
+	//30 * (strength * 0.1f) rounded the wrong way for hundreds of strengths once truncated into
+	//an int input, integer math keeps this and the fixed point engines in exact agreement
+	if (floatInputReference) {
+		return static_cast<int>(30 * (strength * 0.1f));
+	}
+	return 3 * strength;
+}
+
+//packed synapse record, 8 bytes
+//locking is done through synapseStripe() rather than a mutex per synapse
+//the parent isn't stored, a synapse is only ever reached through its parent's childSynapses
+//and spikes carry the neuron that fired them
+struct Synapse {
+
+	uint32_t childNeuron = 0;	//neuron ref
+	//manually set neuron strength to 100 when setting up base netowrk synapses
+	//cap total value at maybe 1000
+	int16_t strength = 1;
+	//saturates, reward buckets stop at 100
+	uint8_t age = 0;
+
+	//pruning pass counters, reset by activity
+	uint8_t idleSweeps : 4;
+	uint8_t weakSweeps : 4;
+
+	Synapse() : idleSweeps(0), weakSweeps(0) {}
+
+	//caller holds synapseStripe for this synapse
+	void rewardSynapse(bool reward, const int& amount) {
+
+		int ageMultiplyer = 0;
+
+		//young synapses should respond more strongly to feedback
+		//older neurons will benefit from more stability
+
+		if (age < 5) {
+			ageMultiplyer = 20;
+		}
+		else if (age < 20) {
+			ageMultiplyer = 5;
+		}
+		else if (age < 100) {
+			ageMultiplyer = 2;
+		}
+
+		int s = strength;
+		if (s < 0) {
+			reward = !reward;
+		}
+		if (reward) {
+			s += (amount * ageMultiplyer);
+			if (s > 1000) {
+				s = 1000;
+			}
+		}
+		else {
+			s -= (amount * ageMultiplyer);
+			if (s < -1000) {
+				s = -1000;
+			}
+		}
+		strength = static_cast<int16_t>(s);
+		if (age < 255) {
+			age++;
+		}
+	}
+
+};
+
+static_assert(sizeof(Synapse) == 8, "synapse record should stay packed");
+
+//striped locks, a synapse index always maps to the same mutex
+constexpr size_t synapseStripeCount = 256;
+std::mutex synapseStripes[synapseStripeCount];
+
+std::mutex& synapseStripe(uint32_t synapseIndex) {
+	return synapseStripes[synapseIndex % synapseStripeCount];
+}
+
+//guards synapse structure: creating and releasing pool records and adjacency membership.
+//there is no per synapse index, a parent's child list is the lookup (see findSynapse)
+std::shared_mutex synapseMapMutex;
+
+//bumped by every change to the network's structure, neurons or synapses added or removed.
+//engines that run a copy of the brain compare it against the version they copied
+std::atomic<uint64_t> networkVersion{ 0 };
+
+//spikes raised during a tick, delivered at the next tick boundary
+//synapseIndex is noSynapse for external stimulus
+constexpr uint32_t noSynapse = 0xFFFFFFFFu;
+
+struct queuedSpike {
+	uint32_t childNeuron;
+	uint32_t synapseIndex;
+	int strength;
+	uint32_t parentNeuron = 0;	//the neuron that fired it, only meaningful with a synapseIndex
+};
+
+std::mutex spikeQueueMute;
+std::vector<queuedSpike> spikeQueue;
+
+void queueSpike(uint32_t childNeuron, uint32_t synapseIndex, int strength) {
+	std::lock_guard<std::mutex> lock(spikeQueueMute);
+	spikeQueue.push_back({ childNeuron, synapseIndex, strength });
+}
+
+//-------------------------
+//epoch based reclamation
+//readers of published data hold an epochGuard while they look at it. a writer that replaces
+//something retires the old copy instead of freeing it, and it is only freed once every reader
+//that entered before the swap has left. readers never lock and never copy
+
+constexpr size_t maxEpochReaders = 256;
+
+struct alignas(64) epochSlot {
+	std::atomic<uint64_t> epoch{ 0 };		//0 while the owning thread is outside every guard
+	std::atomic<bool> claimed{ false };
+};
+
+std::atomic<uint64_t> globalEpoch{ 1 };
+epochSlot epochSlots[maxEpochReaders];
+
+struct retiredObject {
+	uint64_t epoch;
+	void* object;
+	void (*destroy)(void*);
+};
+
+std::mutex retiredMute;
+std::vector<retiredObject> retiredObjects;
+
+//one slot per thread, claimed on first use and given back when the thread exits
+struct epochThreadState {
+	epochSlot* slot = nullptr;
+	int depth = 0;
+
+	~epochThreadState() {
+		if (slot != nullptr) {
+			slot->epoch.store(0);
+			slot->claimed.store(false);
+		}
+	}
+
+	epochSlot& acquire() {
+		while (slot == nullptr) {
+			for (epochSlot& s : epochSlots) {
+				bool expected = false;
+				if (s.claimed.compare_exchange_strong(expected, true)) {
+					slot = &s;
+					break;
+				}
+			}
+			if (slot == nullptr) {
+				std::this_thread::yield();
+			}
+		}
+		return *slot;
+	}
+};
+
+thread_local epochThreadState epochThread;
+
+class epochGuard {
+public:
+	epochGuard() {
+		if (epochThread.depth++ == 0) {
+			epochThread.acquire().epoch.store(globalEpoch.load());
+		}
+	}
+
+	~epochGuard() {
+		if (--epochThread.depth == 0) {
+			epochThread.slot->epoch.store(0);
+		}
+	}
+
+	epochGuard(const epochGuard&) = delete;
+	epochGuard& operator=(const epochGuard&) = delete;
+};
+
+//frees everything retired before the oldest reader still inside a guard
+void reclaimRetired() {
+	uint64_t oldest = std::numeric_limits<uint64_t>::max();
+	for (const epochSlot& s : epochSlots) {
+		uint64_t e = s.epoch.load();
+		if (e != 0) {
+			oldest = std::min(oldest, e);
+		}
+	}
+
+	std::vector<retiredObject> ready;
+	{
+		std::lock_guard<std::mutex> lock(retiredMute);
+		auto keep = std::partition(retiredObjects.begin(), retiredObjects.end(), [oldest](const retiredObject& r) {
+			return r.epoch >= oldest;
+		});
+		ready.assign(keep, retiredObjects.end());
+		retiredObjects.erase(keep, retiredObjects.end());
+	}
+	for (const retiredObject& r : ready) {
+		r.destroy(r.object);
+	}
+}
+
+//call after the replacement has been published
+template <typename T>
+void retire(T* object) {
+	uint64_t epoch = globalEpoch.fetch_add(1);
+	size_t pending;
+	{
+		std::lock_guard<std::mutex> lock(retiredMute);
+		retiredObjects.push_back({ epoch, object, [](void* p) { delete static_cast<T*>(p); } });
+		pending = retiredObjects.size();
+	}
+	if (pending >= 4096) {
+		reclaimRetired();
+	}
+}
+
+//synapse index list with read-copy-update publishing. readers take a view inside an epochGuard
+//and iterate it without locks. appends fill spare capacity in place and publish the new count,
+//entries below the published count never change, so readers see either the old or the new length.
+//anything else builds a new block, swaps it in and retires the old one.
+//writers serialise on the owning neuron's adjacencyMute
+class adjacencyList {
+public:
+	struct view {
+		const uint32_t* first = nullptr;
+		const uint32_t* last = nullptr;
+		const uint32_t* begin() const { return first; }
+		const uint32_t* end() const { return last; }
+		size_t size() const { return static_cast<size_t>(last - first); }
+	};
+
+	adjacencyList() = default;
+	adjacencyList(const adjacencyList&) = delete;
+	adjacencyList& operator=(const adjacencyList&) = delete;
+
+	~adjacencyList() {
+		//only destroyed with the neuron, when no reader can reach it
+		delete current.load(std::memory_order_relaxed);
+	}
+
+	//sequentially consistent so the load can't be ordered before the guard's epoch store
+	view read() const {
+		const block* b = current.load();
+		if (b == nullptr) {
+			return {};
+		}
+		const uint32_t* items = b->items.get();
+		return { items, items + b->count.load(std::memory_order_acquire) };
+	}
+
+	size_t size() const {
+		const block* b = current.load();
+		return b == nullptr ? 0 : b->count.load(std::memory_order_acquire);
+	}
+
+	size_t capacityBytes() const {
+		const block* b = current.load();
+		return b == nullptr ? 0 : sizeof(block) + b->capacity * sizeof(uint32_t);
+	}
+
+	void append(uint32_t value) {
+		block* b = current.load(std::memory_order_relaxed);
+		uint32_t count = b == nullptr ? 0 : b->count.load(std::memory_order_relaxed);
+		if (b != nullptr && count < b->capacity) {
+			b->items[count] = value;
+			b->count.store(count + 1, std::memory_order_release);
+			return;
+		}
+		//grows by half rather than doubling, spare slots are most of a synapse's adjacency cost
+		block* grown = new block(std::max<uint32_t>(4, count + count / 2));
+		if (count > 0) {
+			std::memcpy(grown->items.get(), b->items.get(), count * sizeof(uint32_t));
+		}
+		grown->items[count] = value;
+		grown->count.store(count + 1, std::memory_order_relaxed);
+		publish(grown);
+	}
+
+	//copies the entries that survive into a right sized block, returns how many were removed
+	template <typename Pred>
+	size_t removeIf(Pred&& remove) {
+		view old = read();
+		std::vector<uint32_t> kept;
+		kept.reserve(old.size());
+		for (uint32_t value : old) {
+			if (!remove(value)) {
+				kept.push_back(value);
+			}
+		}
+		size_t removed = old.size() - kept.size();
+		if (removed == 0) {
+			return 0;
+		}
+		block* fresh = nullptr;
+		if (!kept.empty()) {
+			fresh = new block(static_cast<uint32_t>(kept.size()));
+			std::memcpy(fresh->items.get(), kept.data(), kept.size() * sizeof(uint32_t));
+			fresh->count.store(static_cast<uint32_t>(kept.size()), std::memory_order_relaxed);
+		}
+		publish(fresh);
+		return removed;
+	}
+
+private:
+	struct block {
+		explicit block(uint32_t cap) : capacity(cap), items(new uint32_t[cap]) {}
+		std::atomic<uint32_t> count{ 0 };
+		uint32_t capacity;
+		std::unique_ptr<uint32_t[]> items;
+	};
+
+	void publish(block* replacement) {
+		block* old = current.exchange(replacement);
+		if (old != nullptr) {
+			retire(old);
+		}
+	}
+
+	std::atomic<block*> current{ nullptr };
+};
+
+//what a bank update needs from the store it runs in
+struct tickContext {
+	slabPool<Synapse>& synapses;
+	bool lockSynapses;		//false when one worker owns the store outright
+	std::vector<queuedSpike>& out;
+	std::vector<uint32_t>* fired = nullptr;	//refs of neurons that fired, when someone is recording
+	uint32_t current = 0;	//ref of the neuron being updated
+};
+
+//reads each child synapse of a firing neuron into the outgoing batch
+//caller holds an epochGuard
+void chargeChildSynapses(tickContext& ctx, const adjacencyList& childSynapses) {
+	for (uint32_t synapseIndex : childSynapses.read()) {
+		std::unique_lock<std::mutex> stripe(synapseStripe(synapseIndex), std::defer_lock);
+		if (ctx.lockSynapses) {
+			stripe.lock();
+		}
+		Synapse& s = ctx.synapses.at(synapseIndex);
+		s.idleSweeps = 0;
+		ctx.out.push_back({ s.childNeuron, synapseIndex, s.strength, ctx.current });
+	}
+}
+
+int adjustThreshold(const int& fireThreshold, size_t parentCount) {
+	//subject to change
+	return fireThreshold + static_cast<int>(parentCount);
+}
+
+//-------------------------
+//neuron types
+//each type is a plain state struct plus a policy with a static per tick update,
+//the engine runs one loop per type so there is no virtual call or cast on the spike path.
+//to add a type: write the state and policy, give it a bank in networkStore and a case in visitNeuron
+
+struct genericNeuronState {
+	neuronPosition positionData;
+
+	int input = 0;
+	float neuronCharge = -65;
+	int fireThreshold = -55;
+	int exhaustionLevel = 0;
+	bool canFire = true;
+
+	//low 32 bits of tickCount at the last two fires, 0 for never
+	uint32_t lastFired = 0;
+	uint32_t previousFired = 0;
+
+	std::mutex adjacencyMute;		//serialises adjacency writers, readers don't take it
+	adjacencyList childSynapses;
+	//parent count, including parents in other shards. parents aren't listed, nothing walks
+	//synapses backwards and a second list would cost 4 more bytes per synapse
+	std::atomic<uint32_t> fanIn{ 0 };
+};
+
+struct genericPolicy {
+	using state = genericNeuronState;
+	static constexpr NeuronType type = NeuronType::generic;
+	static constexpr bool hasChildren = true;
+
+	static bool update(state& n, tickContext& ctx) {
+
+		//resting with nothing incoming, nothing below would change
+		if (n.input == 0 && n.neuronCharge == -65) {
+			return false;
+		}
+
+		bool shouldFire = false;
+		bool fired = false;
+
+		int adjustedThreshold = adjustThreshold(n.fireThreshold, n.fanIn.load(std::memory_order_relaxed));
+
+		if (n.neuronCharge + n.input > adjustedThreshold) {
+			shouldFire = true;
+		}
+
+		if (n.input > 95) {
+			n.input -= 95;
+		}
+		else {
+			n.input = 0;
+		};
+
+		if (shouldFire && n.canFire) {
+			chargeChildSynapses(ctx, n.childSynapses);
+			fired = true;
+			n.previousFired = n.lastFired;
+			n.lastFired = static_cast<uint32_t>(tickCount);
+		}
+
+		if (fired) {
+			if (n.neuronCharge == -65) {
+				n.neuronCharge = -80;
+				n.exhaustionLevel = 1;
+			}
+			else {
+				n.neuronCharge = -(80 + n.exhaustionLevel);
+				n.exhaustionLevel++;
+			}
+
+			if (n.neuronCharge < -90) {
+				n.canFire = false;
+			}
+		}
+		else {
+			if (n.neuronCharge < -67) {
+				n.neuronCharge += 2;
+			}
+			else if (n.neuronCharge > -63) {
+				n.neuronCharge -= 2;
+			}
+			else {
+				n.neuronCharge = -65;
+			}
+			if (n.neuronCharge == -65) {
+				n.canFire = true;
+				n.exhaustionLevel = 0;
+			}
+		}
+		return fired;
+	}
+
+	//everything but adjacency, for moving a neuron between stores
+	static void copyState(state& to, const state& from) {
+		to.positionData = from.positionData;
+		to.input = from.input;
+		to.neuronCharge = from.neuronCharge;
+		to.fireThreshold = from.fireThreshold;
+		to.exhaustionLevel = from.exhaustionLevel;
+		to.canFire = from.canFire;
+		to.lastFired = from.lastFired;
+		to.previousFired = from.previousFired;
+	}
+};
+
+std::atomic<int> rewardValue{ 0 };
+
+struct rewardNeuronState {
+	neuronPosition positionData;
+
+	int input = 0;
+	int fireThreshold = -55;
+	int reverseThreshold = -75;
+	int cooldown = 0;
+
+	std::mutex adjacencyMute;
+	adjacencyList childSynapses;	//always empty, reward neurons don't connect children
+	std::atomic<uint32_t> fanIn{ 0 };
+};
+
+struct rewardPolicy {
+	using state = rewardNeuronState;
+	static constexpr NeuronType type = NeuronType::reward;
+	static constexpr bool hasChildren = false;
+
+	//tallies directional reward instead of firing
+	static bool update(state& n, tickContext&) {
+
+		if (n.cooldown <= 0) {
+
+			if (n.input > n.fireThreshold) {
+				rewardValue += 1;
+				n.input = 0;
+				n.cooldown = 10;
+			}
+			else if (n.input < n.reverseThreshold) {
+				rewardValue -= 1;
+				n.input = 0;
+				n.cooldown = 10;
+			}
+			else {
+				if (n.input > 2) {
+					n.input -= 2;
+				}
+				if (n.input < -2) {
+					n.input += 2;
+				}
+				else {
+					n.input = 0;
+				}
+			}
+		}
+		else {
+			n.cooldown -= 1;
+		}
+		return false;
+	}
+
+	static void copyState(state& to, const state& from) {
+		to.positionData = from.positionData;
+		to.input = from.input;
+		to.fireThreshold = from.fireThreshold;
+		to.reverseThreshold = from.reverseThreshold;
+		to.cooldown = from.cooldown;
+	}
+};
+
+template <typename Policy>
+struct neuronBank {
+	using policy = Policy;
+	slabPool<typename Policy::state> pool;
+
+	//one tight loop over every neuron of this type
+	void update(tickContext& ctx) {
+		epochGuard guard;
+		pool.forEach([&ctx](uint32_t index, typename Policy::state& n) {
+			ctx.current = makeNeuronRef(Policy::type, index);
+			if (Policy::update(n, ctx) && ctx.fired != nullptr) {
+				ctx.fired->push_back(makeNeuronRef(Policy::type, index));
+			}
+		});
+	}
+};
+
+//everything one engine needs to run a tick: the synapse records and a bank per neuron type
+//the single threaded engine uses the global brain, shards each own one
+struct networkStore {
+	slabPool<Synapse> synapsePool;
+	neuronBank<genericPolicy> genericBank;
+	neuronBank<rewardPolicy> rewardBank;
+
+	//calls f(bank) for every neuron bank, for passes that touch all types
+	template <typename F>
+	void forEachBank(F&& f) {
+		f(genericBank);
+		f(rewardBank);
+	}
+
+	template <typename Policy>
+	neuronBank<Policy>& bankFor() {
+		if constexpr (std::is_same_v<Policy, genericPolicy>) {
+			return genericBank;
+		}
+		else {
+			static_assert(std::is_same_v<Policy, rewardPolicy>, "policy has no bank in networkStore");
+			return rewardBank;
+		}
+	}
+
+	//resolves a neuron ref to its bank, calls f(bank, index) and returns true if the neuron is live
+	template <typename F>
+	bool visitNeuron(uint32_t ref, F&& f) {
+		uint32_t index = neuronRefIndex(ref);
+		switch (neuronRefType(ref)) {
+		case NeuronType::generic:
+			if (!genericBank.pool.isLive(index)) return false;
+			f(genericBank, index);
+			return true;
+		case NeuronType::reward:
+			if (!rewardBank.pool.isLive(index)) return false;
+			f(rewardBank, index);
+			return true;
+		default:
+			return false;
+		}
+	}
+
+	bool neuronLive(uint32_t ref) {
+		return visitNeuron(ref, [](auto&, uint32_t) {});
+	}
+
+	void pushToNeuron(uint32_t neuronRef, int strength) {
+		visitNeuron(neuronRef, [strength](auto& bank, uint32_t index) {
+			bank.pool.at(index).input += calculateInput(strength);
+		});
+	}
+
+	//runs every bank once, spikes from neurons that fire go to out
+	void updateBanks(std::vector<queuedSpike>& out, bool lockSynapses = true,
+		std::vector<uint32_t>* fired = nullptr) {
+		tickContext ctx{ synapsePool, lockSynapses, out, fired };
+		forEachBank([&ctx](auto& bank) {
+			bank.update(ctx);
+		});
+	}
+
+	void clear() {
+		synapsePool.clear();
+		forEachBank([](auto& bank) {
+			bank.pool.clear();
+		});
+	}
+};
+
+networkStore brain;
+
+//position hash -> neuron ref
+std::shared_mutex neuronMapMutex;
+std::unordered_map<std::string, uint32_t> neuronMap;
+
+//canonical order: by receiving neuron, then by strength
+//input is an integer sum so delivery order doesn't change it, but plasticity reads and writes
+//per spike, and ordering by strength doesn't depend on how synapses were numbered, so the
+//single and sharded engines agree
+void sortSpikesCanonically(std::vector<queuedSpike>& batch) {
+	std::sort(batch.begin(), batch.end(), [](const queuedSpike& a, const queuedSpike& b) {
+		if (a.childNeuron != b.childNeuron) {
+			return a.childNeuron < b.childNeuron;
+		}
+		return a.strength < b.strength;
+	});
+}
+
+//nearest spike pairing, evaluated when a presynaptic spike arrives so it needs no pass of its own.
+//the arriving spike was fired last tick; the child's latest fire is paired with the parent's
+//fire before this one (pre then post, potentiation) and with this one (post then pre, depression).
+//both only count a child fire that came after the parent's previous spike, so no pair is used twice.
+//potentiation therefore lands on the parent's next spike rather than the moment the child fires
+void applyTimingPlasticity(const queuedSpike& spike) {
+
+	if (spike.synapseIndex == noSynapse || neuronRefType(spike.childNeuron) != NeuronType::generic) {
+		return;
+	}
+
+	if (neuronRefType(spike.parentNeuron) != NeuronType::generic) {
+		return;
+	}
+	std::lock_guard<std::mutex> stripe(synapseStripe(spike.synapseIndex));
+	Synapse& syn = brain.synapsePool.at(spike.synapseIndex);
+	const genericNeuronState& parent = brain.genericBank.pool.at(neuronRefIndex(spike.parentNeuron));
+	const genericNeuronState& child = brain.genericBank.pool.at(neuronRefIndex(spike.childNeuron));
+
+	uint32_t post = child.lastFired;
+	uint32_t pre = parent.lastFired;
+	uint32_t earlierPre = parent.previousFired;
+	if (post == 0 || static_cast<int32_t>(post - earlierPre) <= 0) {
+		return;
+	}
+
+	int change = 0;
+	uint32_t window = std::max<uint32_t>(1, plasticity.window);
+	if (earlierPre != 0 && post - earlierPre <= window) {
+		change += plasticity.potentiation * static_cast<int>(window + 1 - (post - earlierPre)) / static_cast<int>(window);
+	}
+	if (static_cast<int32_t>(pre - post) >= 0 && pre - post < window) {
+		change -= plasticity.depression * static_cast<int>(window - (pre - post)) / static_cast<int>(window);
+	}
+	if (change == 0) {
+		return;
+	}
+
+	//like rewardSynapse, potentiation grows the magnitude of inhibitory synapses too
+	int s = syn.strength;
+	s += s < 0 ? -change : change;
+	syn.strength = static_cast<int16_t>(std::max(-1000, std::min(1000, s)));
+	if (syn.age < 255) {
+		syn.age++;
+	}
+}
+
+//returns how many spikes were delivered
+size_t deliverQueuedSpikes() {
+	std::vector<queuedSpike> batch;
+	{
+		std::lock_guard<std::mutex> lock(spikeQueueMute);
+		batch.swap(spikeQueue);
+	}
+
+	if (deterministicMode) {
+		sortSpikesCanonically(batch);
+	}
+
+	if (plasticity.enabled && !deferMaintenance) {
+		for (const queuedSpike& spike : batch) {
+			applyTimingPlasticity(spike);
+			brain.pushToNeuron(spike.childNeuron, spike.strength);
+		}
+	}
+	else {
+		for (const queuedSpike& spike : batch) {
+			brain.pushToNeuron(spike.childNeuron, spike.strength);
+		}
+	}
+	return batch.size();
+}
+
+//runs every bank once, spikes from neurons that fire are delivered next tick
+void updateNeuronBanks(std::vector<uint32_t>* fired = nullptr) {
+	std::vector<queuedSpike> out;
+	brain.updateBanks(out, true, fired);
+
+	std::lock_guard<std::mutex> lock(spikeQueueMute);
+	spikeQueue.insert(spikeQueue.end(), out.begin(), out.end());
+}
+
+void updateSynapseStrengths(const bool& reward, const int& amount) {
+	std::shared_lock<std::shared_mutex> lock(synapseMapMutex);
+	brain.synapsePool.forEach([&](uint32_t index, Synapse& syn) {
+		std::lock_guard<std::mutex> stripe(synapseStripe(index));
+		syn.rewardSynapse(reward, amount);
+	});
+}
+
+void calculateReward(const bool& reward) {
+
+	//may mant to instead make a vector of synapses connected to the reward neuron,
+	//minimum of two,
+	//and only add additional punishment to those in the case of a bad match
+	//rather than punishing all as in the current else if
+	//not sure tho
+
+	if ((reward && rewardValue > 0) || (!reward && rewardValue < 0)) {
+		updateSynapseStrengths(reward, 2);
+	}
+	else if ((reward && rewardValue <= -1)) {
+		updateSynapseStrengths(!reward, 1);
+	}
+	else {
+		updateSynapseStrengths(reward, 1);
+	}
+}
+
+//synapse from parent to child, or noSynapse. scans the parent's child list, which replaces a
+//position hash map that cost more per synapse than the synapse itself.
+//caller holds synapseMapMutex, shared or unique
+uint32_t findSynapse(uint32_t parentRef, uint32_t childRef) {
+	epochGuard guard;
+	uint32_t found = noSynapse;
+	brain.visitNeuron(parentRef, [&](auto& bank, uint32_t index) {
+		for (uint32_t synapseIndex : bank.pool.at(index).childSynapses.read()) {
+			if (brain.synapsePool.at(synapseIndex).childNeuron == childRef) {
+				found = synapseIndex;
+				return;
+			}
+		}
+	});
+	return found;
+}
+
+//returns the new synapse index, or noSynapse if nothing was created
+//positions stay in the signature to match main.cpp, neurons are looked up by hash
+uint32_t createSynapse(const cellPosition&, const std::string& parentHash,
+	const cellPosition&, const std::string& childHash) {
+
+	std::shared_lock<std::shared_mutex> lock(neuronMapMutex);
+
+	auto p = neuronMap.find(parentHash);
+	auto c = neuronMap.find(childHash);
+	if (p == neuronMap.end() || c == neuronMap.end()) {
+		return noSynapse;
+	}
+
+	bool parentHasChildren = false;
+	brain.visitNeuron(p->second, [&parentHasChildren](auto& bank, uint32_t) {
+		parentHasChildren = std::decay_t<decltype(bank)>::policy::hasChildren;
+	});
+	if (!parentHasChildren) {
+		return noSynapse;
+	}
+
+	uint32_t newIndex;
+	{
+		//the duplicate check and the append happen under one lock so two callers can't both add the pair
+		std::unique_lock<std::shared_mutex> synapseLock(synapseMapMutex);
+		if (findSynapse(p->second, c->second) != noSynapse) {
+			return noSynapse;  // already connected
+		}
+		newIndex = brain.synapsePool.create().index;
+		Synapse& newSynapse = brain.synapsePool.at(newIndex);
+		newSynapse.childNeuron = c->second;
+
+		brain.visitNeuron(p->second, [newIndex](auto& bank, uint32_t index) {
+			auto& n = bank.pool.at(index);
+			std::lock_guard<std::mutex> adjacencyLock(n.adjacencyMute);
+			n.childSynapses.append(newIndex);
+		});
+	}
+
+	brain.visitNeuron(c->second, [](auto& bank, uint32_t index) {
+		bank.pool.at(index).fanIn++;
+	});
+	networkVersion++;
+	return newIndex;
+}
+
+//-------------------------
+//spatial index
+//octree over neuron positions so range, radius and nearest neighbour queries don't walk all of
+//neuronMap. nodes are cubes with power of two sides, leaves hold up to leafCapacity neurons and
+//split when they overflow, and the root doubles outward when a neuron lands outside it. every node
+//keeps a count per neuron type so type filtered queries skip subtrees with nothing of that type.
+//kept up to date by placeNeuron and releaseNetwork, guarded by spatialIndexMutex
+
+constexpr uint32_t anyNeuronType = 0xFF;
+
+uint32_t neuronTypeBit(NeuronType type) {
+	return 1u << static_cast<uint32_t>(type);
+}
+
+struct spatialEntry {
+	cellPosition position;
+	uint32_t neuronRef;
+};
+
+class neuronOctree {
+public:
+	static constexpr size_t leafCapacity = 16;
+
+	void insert(const cellPosition& pos, uint32_t ref) {
+		if (root < 0) {
+			root = newNode(floorTo(pos.x, initialSize), floorTo(pos.y, initialSize), floorTo(pos.z, initialSize), initialSize);
+		}
+		while (!contains(nodes[root], pos)) {
+			growToward(pos);
+		}
+		insertAt(root, { pos, ref });
+		entries++;
+	}
+
+	void clear() {
+		nodes.clear();
+		freeNodes.clear();
+		root = -1;
+		entries = 0;
+	}
+
+	//inclusive box
+	void queryBox(const cellPosition& low, const cellPosition& high, uint32_t typeMask, std::vector<spatialEntry>& out) const {
+		if (root >= 0) {
+			boxAt(root, low, high, typeMask, out);
+		}
+	}
+
+	//euclidean distance in cells, inclusive
+	void queryRadius(const cellPosition& center, double radius, uint32_t typeMask, std::vector<spatialEntry>& out) const {
+		if (root < 0 || radius < 0) {
+			return;
+		}
+		long reach = static_cast<long>(std::floor(radius));
+		cellPosition low{ center.x - reach, center.y - reach, center.z - reach };
+		cellPosition high{ center.x + reach, center.y + reach, center.z + reach };
+		double limit = radius * radius;
+		std::vector<spatialEntry> box;
+		boxAt(root, low, high, typeMask, box);
+		for (const spatialEntry& e : box) {
+			if (distanceSquared(e.position, center) <= limit) {
+				out.push_back(e);
+			}
+		}
+	}
+
+	//up to k closest neurons, nearest first, ties by ref. a neuron at center itself is included
+	void nearest(const cellPosition& center, size_t k, uint32_t typeMask, double maxDistance, std::vector<spatialEntry>& out) const {
+		if (root < 0 || k == 0) {
+			return;
+		}
+		double limit = maxDistance * maxDistance;
+
+		//best first over nodes by their closest possible point
+		using candidate = std::pair<double, int32_t>;
+		std::vector<candidate> frontier{ { nodeDistanceSquared(nodes[root], center), root } };
+		auto nodeOrder = [](const candidate& a, const candidate& b) { return a.first > b.first; };
+
+		//max heap of the k best so far
+		using found = std::pair<double, spatialEntry>;
+		auto foundOrder = [](const found& a, const found& b) {
+			return a.first != b.first ? a.first < b.first : a.second.neuronRef < b.second.neuronRef;
+		};
+		std::vector<found> best;
+
+		while (!frontier.empty()) {
+			std::pop_heap(frontier.begin(), frontier.end(), nodeOrder);
+			candidate next = frontier.back();
+			frontier.pop_back();
+			if (next.first > limit || (best.size() == k && next.first > best.front().first)) {
+				break;
+			}
+			const octreeNode& n = nodes[next.second];
+			if (n.leaf) {
+				for (const spatialEntry& e : n.points) {
+					if (!(typeMask & neuronTypeBit(neuronRefType(e.neuronRef)))) {
+						continue;
+					}
+					double d = distanceSquared(e.position, center);
+					if (d > limit) {
+						continue;
+					}
+					found f{ d, e };
+					if (best.size() < k) {
+						best.push_back(f);
+						std::push_heap(best.begin(), best.end(), foundOrder);
+					}
+					else if (foundOrder(f, best.front())) {
+						std::pop_heap(best.begin(), best.end(), foundOrder);
+						best.back() = f;
+						std::push_heap(best.begin(), best.end(), foundOrder);
+					}
+				}
+				continue;
+			}
+			for (int32_t child : n.children) {
+				if (child >= 0 && hasType(nodes[child], typeMask)) {
+					frontier.push_back({ nodeDistanceSquared(nodes[child], center), child });
+					std::push_heap(frontier.begin(), frontier.end(), nodeOrder);
+				}
+			}
+		}
+
+		std::sort_heap(best.begin(), best.end(), foundOrder);
+		for (const found& f : best) {
+			out.push_back(f.second);
+		}
+	}
+
+	size_t size() const { return entries; }
+
+	size_t bytesUsed() const {
+		size_t bytes = nodes.capacity() * sizeof(octreeNode) + freeNodes.capacity() * sizeof(int32_t);
+		for (const octreeNode& n : nodes) {
+			bytes += n.points.capacity() * sizeof(spatialEntry);
+		}
+		return bytes;
+	}
+
+private:
+	static constexpr long initialSize = 16;
+
+	struct octreeNode {
+		long x, y, z;		//low corner
+		long size;			//side length, a power of two
+		int32_t children[8];
+		bool leaf = true;
+		uint32_t count = 0;
+		uint32_t typeCounts[8] = {};
+		std::vector<spatialEntry> points;	//leaves only
+	};
+
+	static long floorTo(long value, long size) {
+		long q = value / size;
+		if (value % size != 0 && value < 0) {
+			q--;
+		}
+		return q * size;
+	}
+
+	static bool contains(const octreeNode& n, const cellPosition& p) {
+		return p.x >= n.x && p.x < n.x + n.size && p.y >= n.y && p.y < n.y + n.size && p.z >= n.z && p.z < n.z + n.size;
+	}
+
+	static bool hasType(const octreeNode& n, uint32_t typeMask) {
+		for (uint32_t t = 0; t < 8; t++) {
+			if ((typeMask & (1u << t)) && n.typeCounts[t] > 0) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+	static double distanceSquared(const cellPosition& a, const cellPosition& b) {
+		double dx = static_cast<double>(a.x - b.x);
+		double dy = static_cast<double>(a.y - b.y);
+		double dz = static_cast<double>(a.z - b.z);
+		return dx * dx + dy * dy + dz * dz;
+	}
+
+	static double nodeDistanceSquared(const octreeNode& n, const cellPosition& p) {
+		auto axis = [](long v, long low, long size) {
+			if (v < low) {
+				return static_cast<double>(low - v);
+			}
+			if (v > low + size - 1) {
+				return static_cast<double>(v - (low + size - 1));
+			}
+			return 0.0;
+		};
+		double dx = axis(p.x, n.x, n.size);
+		double dy = axis(p.y, n.y, n.size);
+		double dz = axis(p.z, n.z, n.size);
+		return dx * dx + dy * dy + dz * dz;
+	}
+
+	int32_t newNode(long x, long y, long z, long size) {
+		int32_t index;
+		if (!freeNodes.empty()) {
+			index = freeNodes.back();
+			freeNodes.pop_back();
+			nodes[index] = octreeNode();
+		}
+		else {
+			index = static_cast<int32_t>(nodes.size());
+			nodes.emplace_back();
+		}
+		octreeNode& n = nodes[index];
+		n.x = x;
+		n.y = y;
+		n.z = z;
+		n.size = size;
+		std::fill(std::begin(n.children), std::end(n.children), -1);
+		return index;
+	}
+
+	int octant(const octreeNode& n, const cellPosition& p) const {
+		long half = n.size / 2;
+		return (p.x >= n.x + half ? 1 : 0) | (p.y >= n.y + half ? 2 : 0) | (p.z >= n.z + half ? 4 : 0);
+	}
+
+	//doubles the root, keeping the old root as one of the new root's children
+	void growToward(const cellPosition& p) {
+		const octreeNode old = nodes[root];
+		long x = p.x < old.x ? old.x - old.size : old.x;
+		long y = p.y < old.y ? old.y - old.size : old.y;
+		long z = p.z < old.z ? old.z - old.size : old.z;
+		int32_t grown = newNode(x, y, z, old.size * 2);
+		octreeNode& g = nodes[grown];
+		g.leaf = false;
+		g.count = old.count;
+		std::copy(std::begin(old.typeCounts), std::end(old.typeCounts), std::begin(g.typeCounts));
+		if (old.count > 0 || !old.leaf) {
+			g.children[octant(g, { old.x, old.y, old.z })] = root;
+		}
+		else {
+			freeNodes.push_back(root);
+		}
+		root = grown;
+	}
+
+	void insertAt(int32_t index, const spatialEntry& e) {
+		while (true) {
+			octreeNode& n = nodes[index];
+			n.count++;
+			n.typeCounts[static_cast<uint32_t>(neuronRefType(e.neuronRef)) & 7]++;
+			if (n.leaf) {
+				n.points.push_back(e);
+				if (n.points.size() > leafCapacity && n.size > 1) {
+					split(index);
+				}
+				return;
+			}
+			int o = octant(n, e.position);
+			if (n.children[o] < 0) {
+				long half = n.size / 2;
+				long x = n.x + ((o & 1) ? half : 0);
+				long y = n.y + ((o & 2) ? half : 0);
+				long z = n.z + ((o & 4) ? half : 0);
+				int32_t child = newNode(x, y, z, half);
+				nodes[index].children[o] = child;
+			}
+			index = nodes[index].children[o];
+		}
+	}
+
+	void split(int32_t index) {
+		std::vector<spatialEntry> points = std::move(nodes[index].points);
+		octreeNode& n = nodes[index];
+		n.points.clear();
+		n.leaf = false;
+		n.count -= static_cast<uint32_t>(points.size());
+		for (uint32_t& c : n.typeCounts) {
+			c = 0;
+		}
+		for (const spatialEntry& e : points) {
+			insertAt(index, e);
+		}
+	}
+
+	void boxAt(int32_t index, const cellPosition& low, const cellPosition& high, uint32_t typeMask,
+		std::vector<spatialEntry>& out) const {
+		const octreeNode& n = nodes[index];
+		if (n.x > high.x || n.x + n.size - 1 < low.x || n.y > high.y || n.y + n.size - 1 < low.y ||
+			n.z > high.z || n.z + n.size - 1 < low.z || !hasType(n, typeMask)) {
+			return;
+		}
+		if (n.leaf) {
+			for (const spatialEntry& e : n.points) {
+				const cellPosition& p = e.position;
+				if (p.x >= low.x && p.x <= high.x && p.y >= low.y && p.y <= high.y && p.z >= low.z && p.z <= high.z &&
+					(typeMask & neuronTypeBit(neuronRefType(e.neuronRef)))) {
+					out.push_back(e);
+				}
+			}
+			return;
+		}
+		for (int32_t child : n.children) {
+			if (child >= 0) {
+				boxAt(child, low, high, typeMask, out);
+			}
+		}
+	}
+
+	std::vector<octreeNode> nodes;
+	std::vector<int32_t> freeNodes;
+	int32_t root = -1;
+	size_t entries = 0;
+};
+
+//taken on its own, never while asking for another lock
+std::shared_mutex spatialIndexMutex;
+neuronOctree spatialIndex;
+
+std::vector<spatialEntry> neuronsInBox(const cellPosition& low, const cellPosition& high, uint32_t typeMask = anyNeuronType) {
+	std::vector<spatialEntry> out;
+	std::shared_lock<std::shared_mutex> lock(spatialIndexMutex);
+	spatialIndex.queryBox(low, high, typeMask, out);
+	return out;
+}
+
+std::vector<spatialEntry> neuronsInRadius(const cellPosition& center, double radius, uint32_t typeMask = anyNeuronType) {
+	std::vector<spatialEntry> out;
+	std::shared_lock<std::shared_mutex> lock(spatialIndexMutex);
+	spatialIndex.queryRadius(center, radius, typeMask, out);
+	return out;
+}
+
+std::vector<spatialEntry> nearestNeurons(const cellPosition& center, size_t k, uint32_t typeMask = anyNeuronType,
+	double maxDistance = std::numeric_limits<double>::infinity()) {
+	std::vector<spatialEntry> out;
+	std::shared_lock<std::shared_mutex> lock(spatialIndexMutex);
+	spatialIndex.nearest(center, k, typeMask, maxDistance, out);
+	return out;
+}
+
+std::mutex occupiedPositionsMute;
+std::set<cellPosition> occupiedCellPositions;
+
+bool cellPosOccupied(const cellPosition& pos) {
+	return occupiedCellPositions.find(pos) != occupiedCellPositions.end();
+}
+
+std::string computeNeuronPositionHash(const cellPosition& pos) {
+	std::string holder = "";
+	holder += std::to_string(pos.x);
+	holder += std::to_string(pos.y);
+	holder += std::to_string(pos.z);
+	return holder;
+}
+
+//false when the cell is already taken. the caller holds occupiedPositionsMute, so a free cell
+//found under the same lock is still free here
+template <typename Bank>
+bool placeNeuronLocked(Bank& bank, const cellPosition& pos) {
+
+	if (cellPosOccupied(pos)) {
+		return false;
+	}
+	occupiedCellPositions.insert(pos);
+
+	std::string newHash = computeNeuronPositionHash(pos);
+	uint32_t index = bank.pool.create().index;
+
+	bank.pool.at(index).positionData = { pos, newHash };
+
+	uint32_t ref = makeNeuronRef(Bank::policy::type, index);
+	std::unique_lock<std::shared_mutex> mapLock(neuronMapMutex);
+	neuronMap.try_emplace(newHash, ref);
+
+	std::unique_lock<std::shared_mutex> spatialLock(spatialIndexMutex);
+	spatialIndex.insert(pos, ref);
+	networkVersion++;
+	return true;
+}
+
+template <typename Bank>
+bool placeNeuron(Bank& bank, const cellPosition& pos) {
+	std::lock_guard<std::mutex> lock(occupiedPositionsMute);
+	return placeNeuronLocked(bank, pos);
+}
+
+void createNeuron(cellPosition pos, NeuronType type) {
+
+	switch (type) {
+	case NeuronType::generic:
+		placeNeuron(brain.genericBank, pos);
+		break;
+	case NeuronType::reward:
+		//only allow one reward neuron, checked against the bank so a released network can have a new one
+		if (brain.rewardBank.pool.liveCount() > 0) {
+			return;
+		}
+		placeNeuron(brain.rewardBank, pos);
+		break;
+	default:
+		//input and output types don't have a policy yet
+		break;
+	}
+}
+
+//neurons of one type inside a box, ordered z, then y, then x, for wiring an input or output grid
+//such as the ones sampleStimulus feeds
+std::vector<uint32_t> neuronGrid(const cellPosition& low, const cellPosition& high, NeuronType type) {
+	std::vector<spatialEntry> found = neuronsInBox(low, high, neuronTypeBit(type));
+	std::sort(found.begin(), found.end(), [](const spatialEntry& a, const spatialEntry& b) {
+		if (a.position.z != b.position.z) return a.position.z < b.position.z;
+		if (a.position.y != b.position.y) return a.position.y < b.position.y;
+		return a.position.x < b.position.x;
+	});
+	std::vector<uint32_t> refs;
+	refs.reserve(found.size());
+	for (const spatialEntry& e : found) {
+		refs.push_back(e.neuronRef);
+	}
+	return refs;
+}
+
+//distance limited wiring: connects the neuron at pos to its nearest neighbours of the given types
+//within radius, at most maxChildren of them. returns how many synapses were created
+size_t connectNearby(const cellPosition& pos, double radius, size_t maxChildren, uint32_t typeMask = anyNeuronType,
+	int strength = 100) {
+
+	std::string parentHash = computeNeuronPositionHash(pos);
+	std::unordered_set<uint32_t> tried;
+	size_t created = 0;
+
+	//neighbours that are already connected don't count, so keep asking for more until enough
+	//synapses are made or every neuron within radius has been tried.
+	//one extra to start with, the neuron itself comes back at distance 0
+	size_t k = maxChildren + 1;
+	while (created < maxChildren) {
+		std::vector<spatialEntry> near = nearestNeurons(pos, k, typeMask, radius);
+
+		for (const spatialEntry& e : near) {
+			if (created == maxChildren) {
+				break;
+			}
+			if (!tried.insert(e.neuronRef).second) {
+				continue;
+			}
+			if (!(e.position < pos) && !(pos < e.position)) {
+				continue;
+			}
+			uint32_t index = createSynapse(pos, parentHash, e.position, computeNeuronPositionHash(e.position));
+			if (index == noSynapse) {
+				continue;
+			}
+			std::lock_guard<std::mutex> stripe(synapseStripe(index));
+			brain.synapsePool.at(index).strength = static_cast<int16_t>(strength);
+			created++;
+		}
+
+		if (near.size() < k) {
+			break;
+		}
+		k *= 2;
+	}
+	return created;
+}
+
+//writes "x,y,z,type" per neuron in the box, for plotting
+bool dumpNeuronPositions(const std::string& path, const cellPosition& low, const cellPosition& high) {
+	FILE* file = std::fopen(path.c_str(), "w");
+	if (file == nullptr) {
+		return false;
+	}
+	std::fprintf(file, "x,y,z,type\n");
+	for (const spatialEntry& e : neuronsInBox(low, high)) {
+		std::fprintf(file, "%ld,%ld,%ld,%u\n", e.position.x, e.position.y, e.position.z,
+			static_cast<unsigned>(neuronRefType(e.neuronRef)));
+	}
+	return std::fclose(file) == 0;
+}
+
+//-------------------------
+//placement search, the shell scan itself lives in placementSearch.h and is shared with main.cpp.
+//callers hold occupiedPositionsMute
+
+cellPosition findNearbyEmptyPosition(const cellPosition& pos, randomStream& rng) {
+	return findNearbyEmptyPosition(pos, cellPosOccupied, [&rng](int size) { return getRandom(0, size - 1, rng); });
+}
+
+//threads started once and reused by the maintenance passes, instead of new threads every pass.
+//the caller works on the job too, so a pool of n threads runs n + 1 ways
+class workerPool {
+public:
+
+	explicit workerPool(size_t threadCount) {
+		for (size_t i = 0; i < threadCount; i++) {
+			threads.emplace_back([this]() { workerLoop(); });
+		}
+	}
+
+	~workerPool() {
+		{
+			std::lock_guard<std::mutex> lock(poolMute);
+			stopping = true;
+		}
+		wake.notify_all();
+		for (std::thread& t : threads) {
+			t.join();
+		}
+	}
+
+	workerPool(const workerPool&) = delete;
+	workerPool& operator=(const workerPool&) = delete;
+
+	//calls job(i) for every i below count and returns once all of them are done
+	void run(size_t count, const std::function<void(size_t)>& job) {
+		std::lock_guard<std::mutex> runLock(runMute);
+		{
+			std::lock_guard<std::mutex> lock(poolMute);
+			currentJob = &job;
+			jobCount = count;
+			nextIndex = 0;
+			busy = threads.size();
+			generation++;
+		}
+		wake.notify_all();
+
+		drain(job, count);
+
+		std::unique_lock<std::mutex> lock(poolMute);
+		finished.wait(lock, [this]() { return busy == 0; });
+		currentJob = nullptr;
+	}
+
+	size_t ways() const { return threads.size() + 1; }
+
+private:
+
+	void drain(const std::function<void(size_t)>& job, size_t count) {
+		for (size_t i = nextIndex.fetch_add(1); i < count; i = nextIndex.fetch_add(1)) {
+			job(i);
+		}
+	}
+
+	void workerLoop() {
+		uint64_t seen = 0;
+		while (true) {
+			const std::function<void(size_t)>* job;
+			size_t count;
+			{
+				std::unique_lock<std::mutex> lock(poolMute);
+				wake.wait(lock, [this, seen]() { return stopping || generation != seen; });
+				if (stopping) {
+					return;
+				}
+				seen = generation;
+				job = currentJob;
+				count = jobCount;
+			}
+			drain(*job, count);
+			{
+				std::lock_guard<std::mutex> lock(poolMute);
+				if (--busy == 0) {
+					finished.notify_all();
+				}
+			}
+		}
+	}
+
+	std::vector<std::thread> threads;
+	std::mutex runMute;		//one job at a time
+	std::mutex poolMute;
+	std::condition_variable wake;
+	std::condition_variable finished;
+	const std::function<void(size_t)>* currentJob = nullptr;
+	size_t jobCount = 0;
+	std::atomic<size_t> nextIndex{ 0 };
+	size_t busy = 0;
+	uint64_t generation = 0;
+	bool stopping = false;
+};
+
+//started on first use so programs that never prune don't pay for idle threads
+workerPool& maintenanceWorkers() {
+	static workerPool pool(pruning.threads > 0 ? pruning.threads : std::max(1u, std::thread::hardware_concurrency()) - 1);
+	return pool;
+}
+
+//removes dead synapses from every neuron's adjacency lists, split across the maintenance workers
+//one pass per list with a mask lookup instead of an O(n) erase per synapse
+void compactAdjacency(const std::vector<uint8_t>& dead) {
+
+	auto isDead = [&dead](uint32_t synapseIndex) {
+		return synapseIndex < dead.size() && dead[synapseIndex] != 0;
+	};
+
+	workerPool& workers = maintenanceWorkers();
+	//a few chunks per worker so one slow chunk doesn't hold up the pass
+	size_t chunkCount = workers.ways() * 4;
+
+	brain.forEachBank([&](auto& bank) {
+		uint32_t limit = bank.pool.indexLimit();
+		uint32_t chunk = static_cast<uint32_t>((limit + chunkCount - 1) / chunkCount);
+		if (chunk == 0) {
+			return;
+		}
+
+		workers.run((limit + chunk - 1) / chunk, [&bank, &isDead, limit, chunk](size_t c) {
+			uint32_t begin = static_cast<uint32_t>(c) * chunk;
+			uint32_t end = std::min(limit, begin + chunk);
+			for (uint32_t i = begin; i < end; i++) {
+				if (!bank.pool.isLive(i)) {
+					continue;
+				}
+				auto& n = bank.pool.at(i);
+				std::lock_guard<std::mutex> lock(n.adjacencyMute);
+				//survivors go to a right sized block, so long lived neurons get their memory back
+				n.childSynapses.removeIf(isDead);
+			}
+		});
+	});
+}
+
+//drops synapses that stayed near zero strength or went uncharged for too many passes,
+//plus orphans whose parent or child neuron is gone, then compacts the adjacency lists
+size_t pruneSynapses() {
+
+	//same lock order as createSynapse, neuron map before synapse map
+	std::shared_lock<std::shared_mutex> neuronLock(neuronMapMutex);
+	std::unique_lock<std::shared_mutex> synapseLock(synapseMapMutex);
+
+	std::vector<uint8_t> dead(brain.synapsePool.indexLimit(), 0);
+	size_t deadCount = 0;
+
+	//synapses don't record their parent, the ones no live neuron lists have lost it
+	std::vector<uint8_t> listed(brain.synapsePool.indexLimit(), 0);
+	{
+		epochGuard guard;
+		brain.forEachBank([&listed](auto& bank) {
+			using state = typename std::decay_t<decltype(bank)>::policy::state;
+			bank.pool.forEach([&listed](uint32_t, state& n) {
+				for (uint32_t synapseIndex : n.childSynapses.read()) {
+					listed[synapseIndex] = 1;
+				}
+			});
+		});
+	}
+
+	brain.synapsePool.forEach([&](uint32_t index, Synapse& syn) {
+		std::lock_guard<std::mutex> stripe(synapseStripe(index));
+
+		if (syn.idleSweeps < 15) {
+			syn.idleSweeps++;
+		}
+		if (syn.age >= pruning.minWeakAge && std::abs(syn.strength) <= pruning.weakStrength) {
+			if (syn.weakSweeps < 15) {
+				syn.weakSweeps++;
+			}
+		}
+		else {
+			syn.weakSweeps = 0;
+		}
+
+		bool orphan = !listed[index] || !brain.neuronLive(syn.childNeuron);
+
+		if (orphan || syn.idleSweeps > pruning.maxIdleSweeps || syn.weakSweeps > pruning.maxWeakSweeps) {
+			dead[index] = 1;
+			deadCount++;
+			brain.visitNeuron(syn.childNeuron, [](auto& bank, uint32_t child) {
+				bank.pool.at(child).fanIn--;
+			});
+		}
+	});
+
+	if (deadCount == 0) {
+		return 0;
+	}
+
+	compactAdjacency(dead);
+
+	//freed slots are reused by the next createSynapse calls, which keeps the pool dense
+	for (uint32_t index = 0; index < dead.size(); index++) {
+		if (dead[index]) {
+			brain.synapsePool.release(index);
+		}
+	}
+	networkVersion++;
+
+	return deadCount;
+}
+
+//-------------------------
+//growth
+//every interval ticks a worker thread looks through the spikes recorded since the last pass for
+//pairs of nearby neurons that keep firing on the same tick, and ranks the strong pairs. the worker
+//only sees a copy of the window and the positions it needs, it never takes a map lock. placement,
+//the connection check and wiring a new neuron both ways at a low starting strength all happen on
+//the ticking thread after a tick's delivery and banks are done, so growth never holds the map
+//locks while a tick is in flight
+
+//caller holds neuronMapMutex
+bool neuronPositionOf(uint32_t ref, cellPosition& pos) {
+	return brain.visitNeuron(ref, [&pos](auto& bank, uint32_t index) {
+		pos = bank.pool.at(index).positionData.Position;
+	});
+}
+
+struct growthSite {
+	uint32_t first = 0;		//neuron refs of the co-firing pair
+	uint32_t second = 0;
+	cellPosition position;	//midpoint of the pair, moved to a free cell when the plan is applied
+};
+
+class growthEngine {
+public:
+
+	~growthEngine() {
+		discard();
+	}
+
+	//called every tick with the neurons that fired. only the last growth.interval ticks are kept,
+	//passes deferred under load would otherwise let the window grow without limit
+	void observe(const std::vector<uint32_t>& fired) {
+		while (!history.empty() && history.size() >= std::max<uint64_t>(1, growth.interval)) {
+			history.pop_front();
+		}
+		history.emplace_back();
+		for (uint32_t ref : fired) {
+			if (neuronRefType(ref) == NeuronType::generic) {
+				history.back().push_back(ref);
+			}
+		}
+	}
+
+	//hands the recorded window and the positions of the neurons in it to the worker, between
+	//ticks. skipped while the last plan is still pending
+	void startPass() {
+		if (worker.joinable()) {
+			history.clear();
+			return;
+		}
+		std::unordered_map<uint32_t, cellPosition> positions;
+		{
+			std::shared_lock<std::shared_mutex> lock(neuronMapMutex);
+			for (const std::vector<uint32_t>& fired : history) {
+				for (uint32_t ref : fired) {
+					cellPosition pos;
+					if (!positions.count(ref) && neuronPositionOf(ref, pos)) {
+						positions.emplace(ref, pos);
+					}
+				}
+			}
+		}
+		planReady = false;
+		worker = std::thread([this, window = std::move(history), positions = std::move(positions)]() {
+			plan = planGrowth(window, positions);
+			planReady = true;
+		});
+		history.clear();
+	}
+
+	//applies a finished plan, between ticks. wait blocks for a running worker, deterministic mode
+	//always waits so new neurons appear on the same tick every run
+	size_t commitPending(bool wait) {
+		if (!worker.joinable() || (!wait && !planReady)) {
+			return 0;
+		}
+		worker.join();
+		size_t grown = applyPlan(plan);
+		plan.clear();
+		grownNeurons += grown;
+		return grown;
+	}
+
+	//drops the recorded window and any plan, for when the network is released
+	void discard() {
+		if (worker.joinable()) {
+			worker.join();
+		}
+		plan.clear();
+		history.clear();
+		rng = randomStream{ streamIdFromHash("growth"), 0 };
+	}
+
+	size_t grownNeurons = 0;
+
+private:
+
+	static std::vector<growthSite> planGrowth(const std::deque<std::vector<uint32_t>>& window,
+		const std::unordered_map<uint32_t, cellPosition>& positions);
+	size_t applyPlan(const std::vector<growthSite>& sites);
+
+	std::deque<std::vector<uint32_t>> history;		//generic refs fired per tick since the last pass
+	std::thread worker;
+	std::atomic<bool> planReady{ false };
+	std::vector<growthSite> plan;
+	randomStream rng{ streamIdFromHash("growth"), 0 };
+};
+
+growthEngine growthWorker;
+
+bool directlyConnected(uint32_t a, uint32_t b) {
+	return findSynapse(a, b) != noSynapse || findSynapse(b, a) != noSynapse;
+}
+
+//runs on the worker, reads nothing but its arguments
+std::vector<growthSite> growthEngine::planGrowth(const std::deque<std::vector<uint32_t>>& window,
+	const std::unordered_map<uint32_t, cellPosition>& positions) {
+
+	//same tick co-fire counts, pairs keyed lower ref first
+	std::unordered_map<uint64_t, uint32_t> coFires;
+	const long reach = std::max(1, growth.maxDistance);
+
+	for (const std::vector<uint32_t>& fired : window) {
+
+		//bucket by cells of the search distance so only neighbouring buckets are compared
+		std::map<cellPosition, std::vector<std::pair<uint32_t, cellPosition>>> buckets;
+		for (uint32_t ref : fired) {
+			auto known = positions.find(ref);
+			if (known == positions.end()) {
+				continue;
+			}
+			const cellPosition& pos = known->second;
+			cellPosition bucket{ pos.x / reach, pos.y / reach, pos.z / reach };
+			buckets[bucket].push_back({ ref, pos });
+		}
+
+		for (const auto& entry : buckets) {
+			for (long dx = -1; dx <= 1; dx++) {
+				for (long dy = -1; dy <= 1; dy++) {
+					for (long dz = -1; dz <= 1; dz++) {
+						auto other = buckets.find({ entry.first.x + dx, entry.first.y + dy, entry.first.z + dz });
+						if (other == buckets.end()) {
+							continue;
+						}
+						for (const auto& a : entry.second) {
+							for (const auto& b : other->second) {
+								if (b.first <= a.first) {
+									continue;
+								}
+								const cellPosition& pa = a.second;
+								const cellPosition& pb = b.second;
+								long distance = std::max({ std::abs(pa.x - pb.x), std::abs(pa.y - pb.y), std::abs(pa.z - pb.z) });
+								if (distance < growth.minDistance || distance > growth.maxDistance) {
+									continue;
+								}
+								coFires[(static_cast<uint64_t>(a.first) << 32) | b.first]++;
+							}
+						}
+					}
+				}
+			}
+		}
+	}
+
+	std::vector<std::pair<uint32_t, uint64_t>> strong;
+	for (const auto& entry : coFires) {
+		if (entry.second >= static_cast<uint32_t>(growth.minCoFires)) {
+			strong.push_back({ entry.second, entry.first });
+		}
+	}
+	//most active first, ties by key so the plan doesn't depend on hash map order
+	std::sort(strong.begin(), strong.end(), [](const auto& x, const auto& y) {
+		return x.first != y.first ? x.first > y.first : x.second < y.second;
+	});
+
+	//every strong pair in order, applyPlan skips the connected and already used ones
+	std::vector<growthSite> sites;
+	for (const auto& candidate : strong) {
+		uint32_t a = static_cast<uint32_t>(candidate.second >> 32);
+		uint32_t b = static_cast<uint32_t>(candidate.second);
+		const cellPosition& pa = positions.at(a);
+		const cellPosition& pb = positions.at(b);
+		sites.push_back({ a, b, { (pa.x + pb.x) / 2, (pa.y + pb.y) / 2, (pa.z + pb.z) / 2 } });
+	}
+	return sites;
+}
+
+//the whole plan goes in under one hold of the position lock, so nothing else places a neuron
+//between a site's free cell being found and taken
+size_t growthEngine::applyPlan(const std::vector<growthSite>& sites) {
+
+	size_t grown = 0;
+	std::unordered_set<uint32_t> used;
+	std::lock_guard<std::mutex> positionLock(occupiedPositionsMute);
+
+	for (const growthSite& site : sites) {
+		if (grown >= growth.maxNewNeurons) {
+			break;
+		}
+		//one new neuron per neuron per pass keeps growth from clumping on a single hub
+		if (used.count(site.first) || used.count(site.second)) {
+			continue;
+		}
+		cellPosition first;
+		cellPosition second;
+		{
+			std::shared_lock<std::shared_mutex> neuronLock(neuronMapMutex);
+			if (!neuronPositionOf(site.first, first) || !neuronPositionOf(site.second, second)) {
+				continue;
+			}
+			std::shared_lock<std::shared_mutex> synapseLock(synapseMapMutex);
+			if (directlyConnected(site.first, site.second)) {
+				continue;
+			}
+		}
+
+		cellPosition pos = site.position;
+		if (cellPosOccupied(pos)) {
+			pos = findNearbyEmptyPosition(pos, rng);
+		}
+		if (!placeNeuronLocked(brain.genericBank, pos)) {
+			continue;
+		}
+		used.insert(site.first);
+		used.insert(site.second);
+
+		std::string hash = computeNeuronPositionHash(pos);
+		std::string firstHash = computeNeuronPositionHash(first);
+		std::string secondHash = computeNeuronPositionHash(second);
+
+		uint32_t created[] = {
+			createSynapse(first, firstHash, pos, hash),
+			createSynapse(pos, hash, second, secondHash),
+			createSynapse(second, secondHash, pos, hash),
+			createSynapse(pos, hash, first, firstHash),
+		};
+		for (uint32_t index : created) {
+			if (index == noSynapse) {
+				continue;
+			}
+			std::lock_guard<std::mutex> stripe(synapseStripe(index));
+			brain.synapsePool.at(index).strength = static_cast<int16_t>(growth.initialStrength);
+		}
+		grown++;
+	}
+	return grown;
+}
+
+//firedNeurons, when given, collects the refs of every neuron that fired this tick
+void tick(std::vector<uint32_t>* firedNeurons) {
+	clockState = !clockState;
+	tickCount++;
+
+	std::vector<uint32_t> growthFired;
+	if (growth.interval > 0 && firedNeurons == nullptr) {
+		firedNeurons = &growthFired;
+	}
+
+	{
+		//keeps releaseNetwork out while the banks are running
+		std::shared_lock<std::shared_mutex> lock(neuronMapMutex);
+		deliverQueuedSpikes();
+		updateNeuronBanks(firedNeurons);
+	}
+
+	//growth planned during earlier ticks lands here, after the tick's delivery and banks
+	if (!deferMaintenance) {
+		growthWorker.commitPending(deterministicMode);
+	}
+
+	if (pruning.interval > 0 && tickCount % pruning.interval == 0) {
+		maintenance.pruneDue = true;
+	}
+	if (maintenance.pruneDue && !deferMaintenance) {
+		pruneSynapses();
+		maintenance.pruneDue = false;
+	}
+
+	if (growth.interval > 0) {
+		growthWorker.observe(*firedNeurons);
+		if (tickCount % growth.interval == 0) {
+			maintenance.growthDue = true;
+		}
+		if (maintenance.growthDue && !deferMaintenance) {
+			growthWorker.startPass();
+			maintenance.growthDue = false;
+		}
+	}
+	//frees adjacency blocks replaced so far once no reader can still see them
+	reclaimRetired();
+}
+
+void tick() {
+	tick(nullptr);
+}
+
+struct plasticityBenchmark {
+	uint64_t ticks = 0;
+	uint64_t plainSpikes = 0;
+	uint64_t plasticSpikes = 0;
+	double plainNanos = 0;
+	double plasticNanos = 0;
+};
+
+//steps the brain like tick does with plasticity alternately off and on, so both sides see the
+//same network and activity, and reports the cost per delivered spike. only the delivery loop is
+//timed, the banks and everything after them cost the same either way and would hide the
+//difference. pruning and growth don't run, so the network stays fixed.
+//the brain is advanced as a side effect
+plasticityBenchmark benchmarkPlasticity(uint64_t ticks) {
+	plasticitySettings saved = plasticity;
+	plasticityBenchmark result;
+
+	for (uint64_t t = 0; t < ticks; t++) {
+		plasticity.enabled = (t % 2) == 1;
+		clockState = !clockState;
+		tickCount++;
+
+		size_t pending;
+		double nanos;
+		{
+			std::shared_lock<std::shared_mutex> lock(neuronMapMutex);
+			auto start = std::chrono::steady_clock::now();
+			pending = deliverQueuedSpikes();
+			nanos = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+			updateNeuronBanks();
+		}
+		reclaimRetired();
+
+		if (plasticity.enabled) {
+			result.plasticSpikes += pending;
+			result.plasticNanos += nanos;
+		}
+		else {
+			result.plainSpikes += pending;
+			result.plainNanos += nanos;
+		}
+		result.ticks++;
+	}
+
+	plasticity = saved;
+	return result;
+}
+
+void printPlasticityBenchmark(const plasticityBenchmark& b) {
+	double plain = b.plainSpikes ? b.plainNanos / b.plainSpikes : 0;
+	double plastic = b.plasticSpikes ? b.plasticNanos / b.plasticSpikes : 0;
+	std::printf("plasticity over %llu ticks: %.1f ns per spike plain, %.1f ns per spike with timing plasticity",
+		static_cast<unsigned long long>(b.ticks), plain, plastic);
+	if (plain > 0) {
+		std::printf(" (%+.1f%%)", (plastic / plain - 1.0) * 100.0);
+	}
+	std::printf("\n");
+}
+
+//rough heap accounting for the storage above
+struct memoryReport {
+	size_t neuronCount = 0;
+	size_t synapseCount = 0;
+
+	size_t neuronBytes = 0;			//live neuron objects plus their hash strings
+	size_t neuronIndexBytes = 0;	//neuronMap and the spatial index
+	size_t synapseBytes = 0;		//live synapse records plus pool generation byte
+	size_t adjacencyBytes = 0;		//child index lists, including spare capacity
+	size_t reservedPoolBytes = 0;	//whole slabs, including free and never used slots
+
+	double bytesPerNeuron() const {
+		return neuronCount ? double(neuronBytes + neuronIndexBytes) / neuronCount : 0.0;
+	}
+	//everything a synapse costs: record, generation byte and its child list entry. there is no
+	//synapse index to add on top. floor is 8 + 1 + 4 = 13 bytes, spare list capacity comes on top
+	double bytesPerSynapse() const {
+		return synapseCount ? double(synapseBytes + adjacencyBytes) / synapseCount : 0.0;
+	}
+};
+
+constexpr double synapseBytesTarget = 16;
+
+size_t heapStringBytes(const std::string& s) {
+	//short strings live inside the object
+	return s.capacity() > 15 ? s.capacity() + 1 : 0;
+}
+
+template <typename Map>
+size_t hashMapBytes(const Map& map) {
+	//one node per entry holding the pair and a next pointer plus a cached hash, one pointer per bucket
+	size_t bytes = map.bucket_count() * sizeof(void*);
+	for (const auto& pair : map) {
+		bytes += sizeof(pair) + 2 * sizeof(void*) + heapStringBytes(pair.first);
+	}
+	return bytes;
+}
+
+memoryReport reportMemory() {
+	std::shared_lock<std::shared_mutex> neuronLock(neuronMapMutex);
+	std::shared_lock<std::shared_mutex> synapseLock(synapseMapMutex);
+	epochGuard guard;
+
+	memoryReport r;
+
+	brain.forEachBank([&r](auto& bank) {
+		using state = typename std::decay_t<decltype(bank)>::policy::state;
+		r.neuronCount += bank.pool.liveCount();
+		r.neuronBytes += bank.pool.liveCount() * (sizeof(state) + 1);
+		r.reservedPoolBytes += bank.pool.bytesReserved();
+		bank.pool.forEach([&r](uint32_t, state& n) {
+			r.neuronBytes += heapStringBytes(n.positionData.hash);
+			r.adjacencyBytes += n.childSynapses.capacityBytes();
+		});
+	});
+	r.neuronIndexBytes = hashMapBytes(neuronMap);
+	{
+		std::shared_lock<std::shared_mutex> spatialLock(spatialIndexMutex);
+		r.neuronIndexBytes += spatialIndex.bytesUsed();
+	}
+
+	r.synapseCount = brain.synapsePool.liveCount();
+	r.synapseBytes = r.synapseCount * (sizeof(Synapse) + 1);
+	r.reservedPoolBytes += brain.synapsePool.bytesReserved();
+	return r;
+}
+
+void printMemoryReport(const memoryReport& r) {
+	std::printf("neurons: %zu, %.1f bytes each (%zu generic object + index)\n",
+		r.neuronCount, r.bytesPerNeuron(), sizeof(genericNeuronState));
+	std::printf("synapses: %zu, %.1f bytes each all in (%zu record + generation + adjacency), target under %.0f %s\n",
+		r.synapseCount, r.bytesPerSynapse(), sizeof(Synapse), synapseBytesTarget,
+		r.bytesPerSynapse() < synapseBytesTarget ? "met" : "missed");
+	std::printf("pool slabs reserved: %zu bytes\n", r.reservedPoolBytes);
+}
+
+//bulk release of the whole network, slabs are kept for the next build
+void releaseNetwork() {
+	//a running growth pass plans for neurons that are about to go, let it finish and drop it
+	growthWorker.discard();
+
+	//createNeuron takes the position lock before the neuron map
+	std::lock_guard<std::mutex> positionLock(occupiedPositionsMute);
+	std::unique_lock<std::shared_mutex> neuronLock(neuronMapMutex);
+	std::unique_lock<std::shared_mutex> synapseLock(synapseMapMutex);
+
+	{
+		std::lock_guard<std::mutex> lock(spikeQueueMute);
+		spikeQueue.clear();
+	}
+
+	neuronMap.clear();
+	occupiedCellPositions.clear();
+	brain.clear();
+	maintenance = maintenanceState{};
+
+	std::unique_lock<std::shared_mutex> spatialLock(spatialIndexMutex);
+	spatialIndex.clear();
+	networkVersion++;
+}
+
+//-------------------------
+//real-time runner
+//drives tick at a fixed rate against absolute deadlines (start + n * period), so a late cycle
+//doesn't push every later one back. a cycle misses when its input, tick and output finish after
+//its deadline. under sustained load the runner sheds work in steps instead of drifting:
+//level 1 defers plasticity, pruning and growth, each further level halves the external stimulus
+//that gets through. levels come back down once the load has stayed low for a while.
+//shedding reacts to wall clock time, so it stays off in deterministic mode
+
+struct realtimeSettings {
+	double rateHz = 1000;
+	int maxShedLevel = 4;			//stimulus keeps 1 in 2^(level - 1) spikes above level 1
+	double shedAbove = 0.9;			//smoothed busy fraction of the period that raises the level
+	double recoverBelow = 0.6;		//and that lowers it again
+	uint64_t recoverCycles = 200;	//cycles below recoverBelow before stepping down
+	uint64_t maxLagCycles = 10;		//further behind than this and the schedule is reset
+	double spinMicros = 100;		//busy wait the end of each sleep, sleep_until alone overshoots
+};
+
+struct realtimeReport {
+	uint64_t cycles = 0;
+	uint64_t deadlineMisses = 0;
+	uint64_t longestMissStreak = 0;		//consecutive misses, what breaks closed loop control
+	uint64_t scheduleResets = 0;		//times the runner fell more than maxLagCycles behind
+	uint64_t droppedStimulus = 0;
+	double periodMicros = 0;
+	double meanMicros = 0;				//cycle latency, start of cycle to end of output
+	double p50Micros = 0;
+	double p90Micros = 0;
+	double p99Micros = 0;
+	double p999Micros = 0;
+	double maxMicros = 0;
+	double startJitterMicros = 0;		//standard deviation of how late cycles started
+	std::vector<uint64_t> cyclesAtLevel;
+};
+
+//input fills the stimulus for a cycle (child neuron ref and strength, synapseIndex noSynapse),
+//output reads the network after the tick. either may be empty
+using realtimeInput = std::function<void(uint64_t cycle, std::vector<queuedSpike>& stimulus)>;
+using realtimeOutput = std::function<void(uint64_t cycle)>;
+
+class realtimeRunner {
+public:
+	realtimeSettings settings;
+
+	realtimeReport run(uint64_t cycles, const realtimeInput& input = {}, const realtimeOutput& output = {}) {
+		using clock = std::chrono::steady_clock;
+		const auto period = std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(1.0 / settings.rateHz));
+		const double periodMicros = std::chrono::duration<double, std::micro>(period).count();
+
+		std::vector<uint64_t> histogram(latencyBuckets, 0);
+
+		realtimeReport report;
+		report.periodMicros = periodMicros;
+		report.cyclesAtLevel.assign(settings.maxShedLevel + 1, 0);
+
+		int level = 0;
+		double busy = 0;		//smoothed fraction of the period spent working
+		uint64_t quietCycles = 0;
+		uint64_t missStreak = 0;
+		double lateSum = 0;
+		double lateSquares = 0;
+		double latencySum = 0;
+		std::vector<queuedSpike> stimulus;
+
+		auto deadline = clock::now() + period;
+		for (uint64_t cycle = 0; cycle < cycles; cycle++) {
+			auto scheduled = deadline - period;
+			auto start = clock::now();
+
+			if (start - scheduled > period * static_cast<int64_t>(settings.maxLagCycles)) {
+				//hopelessly behind, start a new schedule from now rather than rushing to catch up
+				deadline = start + period;
+				scheduled = start;
+				report.scheduleResets++;
+			}
+
+			double lateMicros = std::max(0.0, std::chrono::duration<double, std::micro>(start - scheduled).count());
+			lateSum += lateMicros;
+			lateSquares += lateMicros * lateMicros;
+
+			deferMaintenance = level >= 1;
+
+			stimulus.clear();
+			if (input) {
+				input(cycle, stimulus);
+			}
+			size_t stride = level >= 2 ? static_cast<size_t>(1) << (level - 1) : 1;
+			for (size_t i = 0; i < stimulus.size(); i++) {
+				if (i % stride == 0) {
+					queueSpike(stimulus[i].childNeuron, noSynapse, stimulus[i].strength);
+				}
+			}
+			report.droppedStimulus += stimulus.size() - (stimulus.size() + stride - 1) / stride;
+
+			tick();
+			if (output) {
+				output(cycle);
+			}
+
+			auto finished = clock::now();
+			double latency = std::chrono::duration<double, std::micro>(finished - scheduled).count();
+			double work = std::chrono::duration<double, std::micro>(finished - start).count();
+			latencySum += latency;
+			report.maxMicros = std::max(report.maxMicros, latency);
+			histogram[bucketOf(latency / periodMicros)]++;
+			report.cyclesAtLevel[level]++;
+			report.cycles++;
+
+			if (finished > deadline) {
+				report.deadlineMisses++;
+				missStreak++;
+				report.longestMissStreak = std::max(report.longestMissStreak, missStreak);
+			}
+			else {
+				missStreak = 0;
+			}
+
+			busy = busy * 0.9 + (work / periodMicros) * 0.1;
+			if (!deterministicMode) {
+				if (busy > settings.shedAbove && level < settings.maxShedLevel) {
+					level++;
+					busy = settings.recoverBelow;	//give the new level time to take effect
+					quietCycles = 0;
+				}
+				else if (busy < settings.recoverBelow && level > 0) {
+					if (++quietCycles >= settings.recoverCycles) {
+						level--;
+						quietCycles = 0;
+					}
+				}
+				else {
+					quietCycles = 0;
+				}
+			}
+
+			waitUntil(deadline);
+			deadline += period;
+		}
+		deferMaintenance = false;
+
+		if (report.cycles > 0) {
+			double n = static_cast<double>(report.cycles);
+			report.meanMicros = latencySum / n;
+			double meanLate = lateSum / n;
+			report.startJitterMicros = std::sqrt(std::max(0.0, lateSquares / n - meanLate * meanLate));
+			report.p50Micros = percentile(histogram, report.cycles, 0.5, periodMicros, report.maxMicros);
+			report.p90Micros = percentile(histogram, report.cycles, 0.9, periodMicros, report.maxMicros);
+			report.p99Micros = percentile(histogram, report.cycles, 0.99, periodMicros, report.maxMicros);
+			report.p999Micros = percentile(histogram, report.cycles, 0.999, periodMicros, report.maxMicros);
+		}
+		return report;
+	}
+
+private:
+	//latency histogram in periods: 1% buckets up to four periods, then 16 per doubling
+	static constexpr size_t linearBuckets = 400;
+	static constexpr size_t latencyBuckets = linearBuckets + 16 * 24;
+
+	static size_t bucketOf(double periods) {
+		if (periods < 4) {
+			return static_cast<size_t>(periods * 100);
+		}
+		size_t above = static_cast<size_t>(std::log2(periods / 4) * 16);
+		return std::min(latencyBuckets - 1, linearBuckets + above);
+	}
+
+	static double bucketUpperEdge(size_t bucket) {
+		if (bucket < linearBuckets) {
+			return (bucket + 1) / 100.0;
+		}
+		return 4 * std::exp2((bucket - linearBuckets + 1) / 16.0);
+	}
+
+	template <typename TimePoint>
+	void waitUntil(TimePoint deadline) {
+		auto spin = std::chrono::duration_cast<typename TimePoint::duration>(std::chrono::duration<double, std::micro>(settings.spinMicros));
+		if (deadline - TimePoint::clock::now() > spin) {
+			std::this_thread::sleep_until(deadline - spin);
+		}
+		while (TimePoint::clock::now() < deadline) {
+		}
+	}
+
+	//upper edge of the bucket holding the fraction'th cycle, never above the real maximum
+	static double percentile(const std::vector<uint64_t>& histogram, uint64_t total, double fraction,
+		double periodMicros, double maxMicros) {
+		uint64_t target = static_cast<uint64_t>(std::ceil(fraction * total));
+		uint64_t seen = 0;
+		for (size_t i = 0; i < histogram.size(); i++) {
+			seen += histogram[i];
+			if (seen >= target) {
+				return std::min(maxMicros, bucketUpperEdge(i) * periodMicros);
+			}
+		}
+		return maxMicros;
+	}
+};
+
+void printRealtimeReport(const realtimeReport& r) {
+	std::printf("real time: %llu cycles at %.1f us, %llu deadline misses (%.2f%%), longest streak %llu, %llu schedule resets\n",
+		static_cast<unsigned long long>(r.cycles), r.periodMicros, static_cast<unsigned long long>(r.deadlineMisses),
+		r.cycles ? 100.0 * r.deadlineMisses / r.cycles : 0.0, static_cast<unsigned long long>(r.longestMissStreak),
+		static_cast<unsigned long long>(r.scheduleResets));
+	std::printf("  latency us: mean %.1f, p50 %.1f, p90 %.1f, p99 %.1f, p99.9 %.1f, max %.1f, start jitter %.1f\n",
+		r.meanMicros, r.p50Micros, r.p90Micros, r.p99Micros, r.p999Micros, r.maxMicros, r.startJitterMicros);
+	for (size_t level = 0; level < r.cyclesAtLevel.size(); level++) {
+		if (r.cyclesAtLevel[level] > 0) {
+			std::printf("  shed level %zu: %llu cycles\n", level, static_cast<unsigned long long>(r.cyclesAtLevel[level]));
+		}
+	}
+	if (r.droppedStimulus > 0) {
+		std::printf("  %llu stimulus spikes dropped\n", static_cast<unsigned long long>(r.droppedStimulus));
+	}
+}
+
+//-------------------------
+//dataset pipeline
+//labeled images for training, one visual input and one input showing the label as rendered text.
+//a reader thread pulls files off disk, decoder threads turn them into fixed size bitmaps and render
+//the label, and finished samples wait in a small pool of buffers that are allocated (and locked
+//into memory where the platform allows) once and handed back by the consumer. samples come out in
+//manifest order, so the training loop only blocks if the whole pipeline has fallen behind.
+//
+//manifest: one sample per line, image path then label, "red.ppm the color red".
+//paths are relative to the manifest, blank lines and lines starting with # are skipped.
+//images are binary or ascii PPM (P6, P3) or PGM (P5, P2)
+
+struct datasetSettings {
+	uint32_t visualWidth = 32;
+	uint32_t visualHeight = 32;
+	uint32_t visualChannels = 1;	//1 for gray, 3 keeps rgb
+	uint32_t textWidth = 64;
+	uint32_t textHeight = 16;
+	size_t buffers = 16;			//samples decoded ahead, also the cap on memory used
+	size_t readAhead = 32;			//raw files held between the reader and the decoders
+	size_t decodeThreads = 2;
+	uint64_t epochs = 1;			//passes over the manifest, 0 repeats forever
+	bool shuffle = false;			//new order every epoch, from globalSeed
+	bool lockBuffers = true;
+};
+
+struct trainingSample {
+	uint64_t sequence = 0;			//position in the stream, counting across epochs
+	size_t manifestIndex = 0;
+	std::string label;
+	std::vector<uint8_t> visual;	//visualWidth * visualHeight * visualChannels, row major
+	std::vector<uint8_t> text;		//textWidth * textHeight, 0 or 255
+	bool valid = false;				//false when the image failed to load, the pipeline skips these
+};
+
+struct datasetEntry {
+	std::string path;
+	std::string label;
+};
+
+struct datasetStats {
+	uint64_t delivered = 0;
+	uint64_t decodeFailures = 0;
+	uint64_t consumerWaits = 0;		//times acquireNext found nothing ready
+	double consumerWaitMicros = 0;
+};
+
+//reads a manifest, an unreadable manifest gives an empty list
+std::vector<datasetEntry> loadManifest(const std::string& manifestPath) {
+
+	std::vector<datasetEntry> entries;
+	FILE* file = std::fopen(manifestPath.c_str(), "r");
+	if (file == nullptr) {
+		std::printf("dataset: can't open manifest %s\n", manifestPath.c_str());
+		return entries;
+	}
+
+	std::string directory;
+	size_t slash = manifestPath.find_last_of("/\\");
+	if (slash != std::string::npos) {
+		directory = manifestPath.substr(0, slash + 1);
+	}
+
+	auto trim = [](std::string& s) {
+		size_t first = s.find_first_not_of(" \t\r\n");
+		size_t last = s.find_last_not_of(" \t\r\n");
+		s = first == std::string::npos ? std::string() : s.substr(first, last - first + 1);
+	};
+
+	char buffer[4096];
+	while (std::fgets(buffer, sizeof(buffer), file) != nullptr) {
+		std::string line = buffer;
+		trim(line);
+		if (line.empty() || line[0] == '#') {
+			continue;
+		}
+		size_t split = line.find_first_of(" \t");
+		datasetEntry entry;
+		entry.path = line.substr(0, split);
+		if (split != std::string::npos) {
+			entry.label = line.substr(split + 1);
+			trim(entry.label);
+		}
+		if (!entry.path.empty() && entry.path[0] != '/' && entry.path[0] != '\\') {
+			entry.path = directory + entry.path;
+		}
+		entries.push_back(std::move(entry));
+	}
+	std::fclose(file);
+	return entries;
+}
+
+bool readWholeFile(const std::string& path, std::vector<uint8_t>& bytes) {
+	FILE* file = std::fopen(path.c_str(), "rb");
+	if (file == nullptr) {
+		return false;
+	}
+	bytes.clear();
+	uint8_t chunk[65536];
+	size_t got;
+	while ((got = std::fread(chunk, 1, sizeof(chunk), file)) > 0) {
+		bytes.insert(bytes.end(), chunk, chunk + got);
+	}
+	bool ok = std::ferror(file) == 0;
+	std::fclose(file);
+	return ok;
+}
+
+//decoded netpbm image, always 8 bit with 1 or 3 channels
+struct decodedImage {
+	uint32_t width = 0;
+	uint32_t height = 0;
+	uint32_t channels = 0;
+	std::vector<uint8_t> pixels;
+};
+
+//largest width * height decodeNetpbm accepts, 4096 x 4096. a header alone can claim a huge
+//image, this keeps a bad file from allocating more than 48 MB of pixels
+constexpr size_t netpbmMaxPixels = size_t(1) << 24;
+
+bool decodeNetpbm(const std::vector<uint8_t>& bytes, decodedImage& image) {
+
+	size_t at = 0;
+
+	//header tokens are separated by whitespace, # starts a comment to the end of the line
+	auto nextToken = [&bytes, &at](long& value) {
+		while (at < bytes.size()) {
+			if (bytes[at] == '#') {
+				while (at < bytes.size() && bytes[at] != '\n') {
+					at++;
+				}
+			}
+			else if (std::isspace(bytes[at])) {
+				at++;
+			}
+			else {
+				break;
+			}
+		}
+		if (at >= bytes.size() || !std::isdigit(bytes[at])) {
+			return false;
+		}
+		value = 0;
+		while (at < bytes.size() && std::isdigit(bytes[at])) {
+			value = value * 10 + (bytes[at] - '0');
+			if (value > 1000000) {
+				return false;
+			}
+			at++;
+		}
+		return true;
+	};
+
+	if (bytes.size() < 2 || bytes[0] != 'P') {
+		return false;
+	}
+	char kind = static_cast<char>(bytes[1]);
+	bool ascii = kind == '2' || kind == '3';
+	bool binary = kind == '5' || kind == '6';
+	if (!ascii && !binary) {
+		return false;
+	}
+	image.channels = (kind == '3' || kind == '6') ? 3 : 1;
+	at = 2;
+
+	long width;
+	long height;
+	long maxValue;
+	if (!nextToken(width) || !nextToken(height) || !nextToken(maxValue) ||
+		width <= 0 || height <= 0 || maxValue <= 0 || maxValue > 65535) {
+		return false;
+	}
+	if (static_cast<size_t>(width) * height > netpbmMaxPixels) {
+		return false;
+	}
+
+	size_t values = static_cast<size_t>(width) * height * image.channels;
+	size_t sampleBytes = maxValue > 255 ? 2 : 1;
+
+	//check the payload is there before allocating for it. binary is exact, one whitespace byte
+	//after maxval then the samples. ascii needs at least a digit per value
+	if (binary && (bytes.size() <= at || bytes.size() - at - 1 < values * sampleBytes)) {
+		return false;
+	}
+	if (ascii && bytes.size() - at < values) {
+		return false;
+	}
+
+	image.width = static_cast<uint32_t>(width);
+	image.height = static_cast<uint32_t>(height);
+	image.pixels.resize(values);
+
+	auto scale = [maxValue](long v) {
+		return static_cast<uint8_t>(std::min(v, maxValue) * 255 / maxValue);
+	};
+
+	if (ascii) {
+		for (size_t i = 0; i < values; i++) {
+			long v;
+			if (!nextToken(v)) {
+				return false;
+			}
+			image.pixels[i] = scale(v);
+		}
+		return true;
+	}
+
+	//exactly one whitespace byte after maxval, then raw samples, big endian when 16 bit
+	at++;
+	for (size_t i = 0; i < values; i++) {
+		long v = bytes[at + i * sampleBytes];
+		if (sampleBytes == 2) {
+			v = (v << 8) | bytes[at + i * 2 + 1];
+		}
+		image.pixels[i] = scale(v);
+	}
+	return true;
+}
+
+//box filter when shrinking, nearest when growing, converting channels on the way
+void resampleImage(const decodedImage& image, uint32_t width, uint32_t height, uint32_t channels, uint8_t* out) {
+
+	for (uint32_t y = 0; y < height; y++) {
+		uint32_t y0 = static_cast<uint32_t>(static_cast<uint64_t>(y) * image.height / height);
+		uint32_t y1 = std::max(y0 + 1, static_cast<uint32_t>(static_cast<uint64_t>(y + 1) * image.height / height));
+
+		for (uint32_t x = 0; x < width; x++) {
+			uint32_t x0 = static_cast<uint32_t>(static_cast<uint64_t>(x) * image.width / width);
+			uint32_t x1 = std::max(x0 + 1, static_cast<uint32_t>(static_cast<uint64_t>(x + 1) * image.width / width));
+
+			uint32_t sum[3] = { 0, 0, 0 };
+			for (uint32_t sy = y0; sy < y1; sy++) {
+				for (uint32_t sx = x0; sx < x1; sx++) {
+					const uint8_t* p = &image.pixels[(static_cast<size_t>(sy) * image.width + sx) * image.channels];
+					for (uint32_t c = 0; c < 3; c++) {
+						sum[c] += p[image.channels == 3 ? c : 0];
+					}
+				}
+			}
+			uint32_t area = (y1 - y0) * (x1 - x0);
+			uint8_t* dst = &out[(static_cast<size_t>(y) * width + x) * channels];
+			if (channels == 3) {
+				for (uint32_t c = 0; c < 3; c++) {
+					dst[c] = static_cast<uint8_t>(sum[c] / area);
+				}
+			}
+			else {
+				//integer luma, 0.299 0.587 0.114
+				dst[0] = static_cast<uint8_t>((sum[0] * 77 + sum[1] * 150 + sum[2] * 29) / (256 * area));
+			}
+		}
+	}
+}
+
+//5x7 glyphs, one byte per row with the low 5 bits used. letters render as capitals,
+//anything missing renders as ?
+struct glyph {
+	char character;
+	uint8_t rows[7];
+};
+
+const glyph labelFont[] = {
+	{ ' ', { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 } },
+	{ 'A', { 0x0E, 0x11, 0x11, 0x1F, 0x11, 0x11, 0x11 } },
+	{ 'B', { 0x1E, 0x11, 0x11, 0x1E, 0x11, 0x11, 0x1E } },
+	{ 'C', { 0x0E, 0x11, 0x10, 0x10, 0x10, 0x11, 0x0E } },
+	{ 'D', { 0x1E, 0x11, 0x11, 0x11, 0x11, 0x11, 0x1E } },
+	{ 'E', { 0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x1F } },
+	{ 'F', { 0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x10 } },
+	{ 'G', { 0x0E, 0x11, 0x10, 0x17, 0x11, 0x11, 0x0F } },
+	{ 'H', { 0x11, 0x11, 0x11, 0x1F, 0x11, 0x11, 0x11 } },
+	{ 'I', { 0x0E, 0x04, 0x04, 0x04, 0x04, 0x04, 0x0E } },
+	{ 'J', { 0x07, 0x02, 0x02, 0x02, 0x02, 0x12, 0x0C } },
+	{ 'K', { 0x11, 0x12, 0x14, 0x18, 0x14, 0x12, 0x11 } },
+	{ 'L', { 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x1F } },
+	{ 'M', { 0x11, 0x1B, 0x15, 0x15, 0x11, 0x11, 0x11 } },
+	{ 'N', { 0x11, 0x11, 0x19, 0x15, 0x13, 0x11, 0x11 } },
+	{ 'O', { 0x0E, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E } },
+	{ 'P', { 0x1E, 0x11, 0x11, 0x1E, 0x10, 0x10, 0x10 } },
+	{ 'Q', { 0x0E, 0x11, 0x11, 0x11, 0x15, 0x12, 0x0D } },
+	{ 'R', { 0x1E, 0x11, 0x11, 0x1E, 0x14, 0x12, 0x11 } },
+	{ 'S', { 0x0F, 0x10, 0x10, 0x0E, 0x01, 0x01, 0x1E } },
+	{ 'T', { 0x1F, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04 } },
+	{ 'U', { 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E } },
+	{ 'V', { 0x11, 0x11, 0x11, 0x11, 0x11, 0x0A, 0x04 } },
+	{ 'W', { 0x11, 0x11, 0x11, 0x15, 0x15, 0x15, 0x0A } },
+	{ 'X', { 0x11, 0x11, 0x0A, 0x04, 0x0A, 0x11, 0x11 } },
+	{ 'Y', { 0x11, 0x11, 0x11, 0x0A, 0x04, 0x04, 0x04 } },
+	{ 'Z', { 0x1F, 0x01, 0x02, 0x04, 0x08, 0x10, 0x1F } },
+	{ '0', { 0x0E, 0x11, 0x13, 0x15, 0x19, 0x11, 0x0E } },
+	{ '1', { 0x04, 0x0C, 0x04, 0x04, 0x04, 0x04, 0x0E } },
+	{ '2', { 0x0E, 0x11, 0x01, 0x02, 0x04, 0x08, 0x1F } },
+	{ '3', { 0x1F, 0x02, 0x04, 0x02, 0x01, 0x11, 0x0E } },
+	{ '4', { 0x02, 0x06, 0x0A, 0x12, 0x1F, 0x02, 0x02 } },
+	{ '5', { 0x1F, 0x10, 0x1E, 0x01, 0x01, 0x11, 0x0E } },
+	{ '6', { 0x06, 0x08, 0x10, 0x1E, 0x11, 0x11, 0x0E } },
+	{ '7', { 0x1F, 0x01, 0x02, 0x04, 0x08, 0x08, 0x08 } },
+	{ '8', { 0x0E, 0x11, 0x11, 0x0E, 0x11, 0x11, 0x0E } },
+	{ '9', { 0x0E, 0x11, 0x11, 0x0F, 0x01, 0x02, 0x0C } },
+	{ '.', { 0x00, 0x00, 0x00, 0x00, 0x00, 0x0C, 0x0C } },
+	{ ',', { 0x00, 0x00, 0x00, 0x00, 0x0C, 0x04, 0x08 } },
+	{ '-', { 0x00, 0x00, 0x00, 0x1F, 0x00, 0x00, 0x00 } },
+	{ '\'', { 0x04, 0x04, 0x08, 0x00, 0x00, 0x00, 0x00 } },
+	{ '!', { 0x04, 0x04, 0x04, 0x04, 0x04, 0x00, 0x04 } },
+	{ '?', { 0x0E, 0x11, 0x01, 0x02, 0x04, 0x00, 0x04 } },
+	{ '/', { 0x01, 0x02, 0x02, 0x04, 0x08, 0x08, 0x10 } },
+	{ '&', { 0x0C, 0x12, 0x14, 0x08, 0x15, 0x12, 0x0D } },
+};
+
+const glyph& glyphFor(char c) {
+	static const glyph* table[128] = {};
+	static std::once_flag built;
+	std::call_once(built, []() {
+		for (const glyph& g : labelFont) {
+			table[static_cast<unsigned char>(g.character)] = &g;
+		}
+	});
+	unsigned char u = static_cast<unsigned char>(std::toupper(static_cast<unsigned char>(c)));
+	if (u < 128 && table[u] != nullptr) {
+		return *table[u];
+	}
+	return *table[static_cast<unsigned char>('?')];
+}
+
+//word wraps the label at the largest glyph scale that fits, 6x8 cells at scale 1.
+//text that doesn't fit even at scale 1 is cut off
+void renderLabel(const std::string& label, uint32_t width, uint32_t height, uint8_t* out) {
+
+	std::memset(out, 0, static_cast<size_t>(width) * height);
+
+	auto wrap = [&label](size_t perLine) {
+		std::vector<std::string> lines;
+		std::string line;
+		size_t start = 0;
+		while (start < label.size()) {
+			size_t end = label.find(' ', start);
+			std::string word = label.substr(start, end == std::string::npos ? std::string::npos : end - start);
+			start = end == std::string::npos ? label.size() : end + 1;
+			if (word.empty()) {
+				continue;
+			}
+			while (word.size() > perLine) {
+				if (!line.empty()) {
+					lines.push_back(line);
+					line.clear();
+				}
+				lines.push_back(word.substr(0, perLine));
+				word = word.substr(perLine);
+			}
+			if (!line.empty() && line.size() + 1 + word.size() > perLine) {
+				lines.push_back(line);
+				line.clear();
+			}
+			line += line.empty() ? word : " " + word;
+		}
+		if (!line.empty()) {
+			lines.push_back(line);
+		}
+		return lines;
+	};
+
+	uint32_t scale = 1;
+	std::vector<std::string> lines;
+	for (uint32_t s = 4; s >= 1; s--) {
+		size_t perLine = width / (6 * s);
+		if (perLine == 0) {
+			continue;
+		}
+		lines = wrap(perLine);
+		if (lines.size() * 8 * s <= height || s == 1) {
+			scale = s;
+			break;
+		}
+	}
+
+	for (size_t row = 0; row < lines.size(); row++) {
+		for (size_t col = 0; col < lines[row].size(); col++) {
+			const glyph& g = glyphFor(lines[row][col]);
+			for (uint32_t gy = 0; gy < 7 * scale; gy++) {
+				size_t y = row * 8 * scale + gy;
+				if (y >= height) {
+					break;
+				}
+				uint8_t bits = g.rows[gy / scale];
+				for (uint32_t gx = 0; gx < 5 * scale; gx++) {
+					size_t x = col * 6 * scale + gx;
+					if (x < width && (bits & (0x10 >> (gx / scale)))) {
+						out[y * width + x] = 255;
+					}
+				}
+			}
+		}
+	}
+}
+
+class datasetPipeline {
+public:
+	datasetPipeline() = default;
+	datasetPipeline(const datasetPipeline&) = delete;
+	datasetPipeline& operator=(const datasetPipeline&) = delete;
+
+	~datasetPipeline() {
+		stop();
+		releaseBuffers();
+	}
+
+	//starts the background threads, false if the manifest had nothing in it
+	bool start(const std::string& manifestPath, const datasetSettings& config) {
+		stop();
+		settings = config;
+		settings.buffers = std::max<size_t>(1, settings.buffers);
+		settings.readAhead = std::max<size_t>(1, settings.readAhead);
+		entries = loadManifest(manifestPath);
+		if (entries.empty()) {
+			return false;
+		}
+
+		releaseBuffers();
+		for (size_t i = 0; i < settings.buffers; i++) {
+			storage.emplace_back(new trainingSample());
+			trainingSample& sample = *storage.back();
+			sample.visual.assign(static_cast<size_t>(settings.visualWidth) * settings.visualHeight * settings.visualChannels, 0);
+			sample.text.assign(static_cast<size_t>(settings.textWidth) * settings.textHeight, 0);
+#if !defined(_WIN32)
+			if (settings.lockBuffers) {
+				//best effort, the limit for locked memory is often small
+				mlock(sample.visual.data(), sample.visual.size());
+				mlock(sample.text.data(), sample.text.size());
+			}
+#endif
+			freeBuffers.push_back(storage.back().get());
+		}
+
+		stopping = false;
+		readerDone = false;
+		totalSamples = std::numeric_limits<uint64_t>::max();
+		nextSequence = 0;
+		stats = datasetStats();
+
+		reader = std::thread([this]() { readLoop(); });
+		for (size_t i = 0; i < std::max<size_t>(1, settings.decodeThreads); i++) {
+			decoders.emplace_back([this]() { decodeLoop(); });
+		}
+		return true;
+	}
+
+	void stop() {
+		{
+			std::lock_guard<std::mutex> lock(pipelineMute);
+			stopping = true;
+		}
+		rawReady.notify_all();
+		rawSpace.notify_all();
+		bufferFree.notify_all();
+		sampleReady.notify_all();
+		if (reader.joinable()) {
+			reader.join();
+		}
+		for (std::thread& t : decoders) {
+			t.join();
+		}
+		decoders.clear();
+		rawFiles.clear();
+		ready.clear();
+	}
+
+	//next sample in order, nullptr once every epoch has been delivered or the pipeline stopped.
+	//hand the sample back with recycle when done with it
+	trainingSample* acquireNext() {
+		std::unique_lock<std::mutex> lock(pipelineMute);
+		while (true) {
+			if (nextSequence >= totalSamples || stopping) {
+				return nullptr;
+			}
+			auto found = ready.find(nextSequence);
+			if (found == ready.end()) {
+				stats.consumerWaits++;
+				auto waitStart = std::chrono::steady_clock::now();
+				sampleReady.wait(lock, [this]() {
+					return stopping || nextSequence >= totalSamples || ready.count(nextSequence) != 0;
+				});
+				stats.consumerWaitMicros += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - waitStart).count();
+				continue;
+			}
+			trainingSample* sample = found->second;
+			ready.erase(found);
+			nextSequence++;
+			if (!sample->valid) {
+				freeBuffers.push_back(sample);
+				bufferFree.notify_one();
+				continue;
+			}
+			stats.delivered++;
+			return sample;
+		}
+	}
+
+	void recycle(trainingSample* sample) {
+		if (sample == nullptr) {
+			return;
+		}
+		{
+			std::lock_guard<std::mutex> lock(pipelineMute);
+			freeBuffers.push_back(sample);
+		}
+		bufferFree.notify_one();
+	}
+
+	datasetStats statistics() {
+		std::lock_guard<std::mutex> lock(pipelineMute);
+		return stats;
+	}
+
+	const datasetSettings& config() const {
+		return settings;
+	}
+
+private:
+	struct rawFile {
+		uint64_t sequence;
+		size_t manifestIndex;
+		bool readOk;
+		std::vector<uint8_t> bytes;
+	};
+
+	void releaseBuffers() {
+#if !defined(_WIN32)
+		if (settings.lockBuffers) {
+			for (auto& sample : storage) {
+				munlock(sample->visual.data(), sample->visual.size());
+				munlock(sample->text.data(), sample->text.size());
+			}
+		}
+#endif
+		storage.clear();
+		freeBuffers.clear();
+	}
+
+	void readLoop() {
+		std::vector<size_t> order(entries.size());
+		uint64_t sequence = 0;
+
+		for (uint64_t epoch = 0; settings.epochs == 0 || epoch < settings.epochs; epoch++) {
+			for (size_t i = 0; i < order.size(); i++) {
+				order[i] = i;
+			}
+			if (settings.shuffle) {
+				randomStream rng{ streamIdFromHash("dataset"), epoch << 32 };
+				for (size_t i = order.size(); i > 1; i--) {
+					std::swap(order[i - 1], order[getRandom(0, static_cast<int>(i - 1), rng)]);
+				}
+			}
+
+			for (size_t index : order) {
+				rawFile file{ sequence++, index, false, {} };
+				file.readOk = readWholeFile(entries[index].path, file.bytes);
+
+				std::unique_lock<std::mutex> lock(pipelineMute);
+				rawSpace.wait(lock, [this]() { return stopping || rawFiles.size() < settings.readAhead; });
+				if (stopping) {
+					return;
+				}
+				rawFiles.push_back(std::move(file));
+				lock.unlock();
+				rawReady.notify_one();
+			}
+		}
+
+		std::lock_guard<std::mutex> lock(pipelineMute);
+		readerDone = true;
+		totalSamples = sequence;
+		rawReady.notify_all();
+		sampleReady.notify_all();
+	}
+
+	void decodeLoop() {
+		decodedImage image;
+
+		while (true) {
+			trainingSample* sample;
+			rawFile file;
+			{
+				//take a buffer before the next file, so buffers go out in sequence order and the
+				//oldest outstanding sample always has one
+				std::unique_lock<std::mutex> lock(pipelineMute);
+				bufferFree.wait(lock, [this]() { return stopping || !freeBuffers.empty(); });
+				if (stopping) {
+					return;
+				}
+				sample = freeBuffers.back();
+				freeBuffers.pop_back();
+
+				rawReady.wait(lock, [this]() { return stopping || readerDone || !rawFiles.empty(); });
+				if (stopping || rawFiles.empty()) {
+					freeBuffers.push_back(sample);
+					return;
+				}
+				file = std::move(rawFiles.front());
+				rawFiles.pop_front();
+			}
+			rawSpace.notify_one();
+
+			sample->sequence = file.sequence;
+			sample->manifestIndex = file.manifestIndex;
+			sample->label = entries[file.manifestIndex].label;
+			//a throw here would end the thread and leave this sequence number missing, which
+			//stalls the consumer for good. a sample that couldn't be built is just invalid
+			try {
+				sample->valid = file.readOk && decodeNetpbm(file.bytes, image);
+				if (sample->valid) {
+					resampleImage(image, settings.visualWidth, settings.visualHeight, settings.visualChannels, sample->visual.data());
+					renderLabel(sample->label, settings.textWidth, settings.textHeight, sample->text.data());
+				}
+			}
+			catch (const std::exception&) {
+				sample->valid = false;
+			}
+
+			{
+				std::lock_guard<std::mutex> lock(pipelineMute);
+				if (!sample->valid) {
+					stats.decodeFailures++;
+					if (stats.decodeFailures == 1) {
+						std::printf("dataset: can't load %s, skipping it\n", entries[file.manifestIndex].path.c_str());
+					}
+				}
+				ready.emplace(file.sequence, sample);
+			}
+			sampleReady.notify_all();
+		}
+	}
+
+	datasetSettings settings;
+	std::vector<datasetEntry> entries;
+	std::vector<std::unique_ptr<trainingSample>> storage;
+
+	std::mutex pipelineMute;
+	std::condition_variable rawReady;
+	std::condition_variable rawSpace;
+	std::condition_variable bufferFree;
+	std::condition_variable sampleReady;
+
+	std::deque<rawFile> rawFiles;
+	std::vector<trainingSample*> freeBuffers;
+	std::map<uint64_t, trainingSample*> ready;		//decoded, waiting for their turn
+	uint64_t nextSequence = 0;
+	uint64_t totalSamples = 0;		//known once the reader has finished
+	bool readerDone = false;
+	bool stopping = false;
+	datasetStats stats;
+
+	std::thread reader;
+	std::vector<std::thread> decoders;
+};
+
+//turns a sample into stimulus for two input grids, one neuron ref per pixel in row major order.
+//brighter pixels push harder, dark ones send nothing
+void sampleStimulus(const trainingSample& sample, const std::vector<uint32_t>& visualNeurons,
+	const std::vector<uint32_t>& textNeurons, int maxStrength, std::vector<queuedSpike>& out) {
+
+	auto push = [&out, maxStrength](const std::vector<uint8_t>& pixels, const std::vector<uint32_t>& neurons) {
+		size_t count = std::min(pixels.size(), neurons.size());
+		for (size_t i = 0; i < count; i++) {
+			if (pixels[i] != 0) {
+				out.push_back({ neurons[i], noSynapse, pixels[i] * maxStrength / 255 });
+			}
+		}
+	};
+	push(sample.visual, visualNeurons);
+	push(sample.text, textNeurons);
+}
+
+void printDatasetStats(const datasetStats& s) {
+	std::printf("dataset: %llu samples delivered, %llu failed to load, consumer waited %llu times (%.1f us total)\n",
+		static_cast<unsigned long long>(s.delivered), static_cast<unsigned long long>(s.decodeFailures),
+		static_cast<unsigned long long>(s.consumerWaits), s.consumerWaitMicros);
+}
+
+//-------------------------
+//fixed point engine
+//a compiled copy of the brain's generic neurons with int16 state in flat arrays and the adjacency
+//as one CSR block of int16 strengths. every value the brain's float charge takes is a whole
+//number anyway (charge steps by 2 between -65 and about -92, strength is capped at +-1000), and
+//calculateInput is the integer 3 * strength, so a spike is a single saturating integer add.
+//the update loop is branch free over the arrays, which lets the compiler run it in wide int16 lanes.
+//spikes into other neuron types are dropped, those stay on the single process engine
+
+int16_t saturate16(int value) {
+	return static_cast<int16_t>(std::max(-32768, std::min(32767, value)));
+}
+
+//always the integer formula, also while the brain runs on the float reference
+int fixedInput(int strength) {
+	return 3 * strength;
+}
+
+class fixedPointEngine {
+public:
+
+	//snapshot of the brain, including spikes already queued for next tick
+	void build() {
+		std::shared_lock<std::shared_mutex> neuronLock(neuronMapMutex);
+		std::shared_lock<std::shared_mutex> synapseLock(synapseMapMutex);
+		epochGuard guard;
+
+		globalRefs.clear();
+		std::unordered_map<uint32_t, uint32_t> denseOf;
+
+		brain.genericBank.pool.forEach([&](uint32_t index, genericNeuronState&) {
+			uint32_t ref = makeNeuronRef(NeuronType::generic, index);
+			denseOf[ref] = static_cast<uint32_t>(globalRefs.size());
+			globalRefs.push_back(ref);
+		});
+
+		size_t count = globalRefs.size();
+		input.assign(count, 0);
+		incoming.assign(count, 0);
+		charge.assign(count, -65);
+		threshold.assign(count, 0);
+		exhaustion.assign(count, 0);
+		canFire.assign(count, 1);
+		fired.assign(count, 0);
+		saturated.assign(count, 0);
+		childOffsets.assign(count + 1, 0);
+		childTargets.clear();
+		childStrengths.clear();
+
+		for (uint32_t i = 0; i < count; i++) {
+			genericNeuronState& n = brain.genericBank.pool.at(neuronRefIndex(globalRefs[i]));
+
+			input[i] = saturate16(n.input);
+			charge[i] = saturate16(static_cast<int>(n.neuronCharge));
+			threshold[i] = saturate16(adjustThreshold(n.fireThreshold, n.fanIn.load()));
+			exhaustion[i] = static_cast<uint8_t>(std::min(255, n.exhaustionLevel));
+			canFire[i] = n.canFire ? 1 : 0;
+
+			for (uint32_t synapseIndex : n.childSynapses.read()) {
+				const Synapse& syn = brain.synapsePool.at(synapseIndex);
+				auto target = denseOf.find(syn.childNeuron);
+				if (target == denseOf.end()) {
+					continue;
+				}
+				childTargets.push_back(target->second);
+				childStrengths.push_back(syn.strength);
+			}
+			childOffsets[i + 1] = static_cast<uint32_t>(childTargets.size());
+		}
+
+		std::lock_guard<std::mutex> lock(spikeQueueMute);
+		for (const queuedSpike& spike : spikeQueue) {
+			auto target = denseOf.find(spike.childNeuron);
+			if (target != denseOf.end()) {
+				incoming[target->second] = saturate16(incoming[target->second] + fixedInput(spike.strength));
+			}
+		}
+	}
+
+	//same steps as genericPolicy::update, firedNeurons collects brain refs when given
+	void tick(std::vector<uint32_t>* firedNeurons = nullptr) {
+		size_t count = globalRefs.size();
+
+		for (size_t i = 0; i < count; i++) {
+			int sum = input[i] + incoming[i];
+			//a clipped value, now or in incoming, means the brain's int input has left int16 for good
+			saturated[i] |= (sum != saturate16(sum)) | (incoming[i] == 32767) | (incoming[i] == -32768);
+			input[i] = saturate16(sum);
+			incoming[i] = 0;
+		}
+
+		for (size_t i = 0; i < count; i++) {
+			int in = input[i];
+			int c = charge[i];
+			int e = exhaustion[i];
+
+			bool fire = (c + in > threshold[i]) & (canFire[i] != 0);
+			input[i] = static_cast<int16_t>(in > 95 ? in - 95 : 0);
+
+			int firedCharge = c == -65 ? -80 : -(80 + e);
+			int firedExhaustion = c == -65 ? 1 : e + 1;
+			int restingCharge = c < -67 ? c + 2 : (c > -63 ? c - 2 : -65);
+
+			charge[i] = static_cast<int16_t>(fire ? firedCharge : restingCharge);
+			exhaustion[i] = static_cast<uint8_t>(std::min(255, fire ? firedExhaustion : (restingCharge == -65 ? 0 : e)));
+			canFire[i] = static_cast<uint8_t>(fire ? (firedCharge >= -90) : (restingCharge == -65 ? 1 : canFire[i]));
+			fired[i] = fire;
+		}
+
+		for (size_t i = 0; i < count; i++) {
+			if (!fired[i]) {
+				continue;
+			}
+			if (firedNeurons != nullptr) {
+				firedNeurons->push_back(globalRefs[i]);
+			}
+			for (uint32_t edge = childOffsets[i]; edge < childOffsets[i + 1]; edge++) {
+				uint32_t target = childTargets[edge];
+				incoming[target] = saturate16(incoming[target] + fixedInput(childStrengths[edge]));
+			}
+		}
+	}
+
+	//writes neuron state back, spikes still in flight are dropped
+	void syncToBrain() {
+		std::shared_lock<std::shared_mutex> neuronLock(neuronMapMutex);
+		for (size_t i = 0; i < globalRefs.size(); i++) {
+			uint32_t index = neuronRefIndex(globalRefs[i]);
+			if (!brain.genericBank.pool.isLive(index)) {
+				continue;
+			}
+			genericNeuronState& n = brain.genericBank.pool.at(index);
+			n.input = input[i];
+			n.neuronCharge = charge[i];
+			n.exhaustionLevel = exhaustion[i];
+			n.canFire = canFire[i] != 0;
+		}
+	}
+
+	//neurons whose input or charge differ from the brain's, spike trains can agree while
+	//inputs drift by a little. neurons whose input ever clipped at the int16 limits are skipped,
+	//the brain's int keeps the excess and the two never line up again
+	size_t countStateMismatches() {
+		std::shared_lock<std::shared_mutex> neuronLock(neuronMapMutex);
+		size_t mismatched = 0;
+		for (size_t i = 0; i < globalRefs.size(); i++) {
+			uint32_t index = neuronRefIndex(globalRefs[i]);
+			if (saturated[i] || !brain.genericBank.pool.isLive(index)) {
+				continue;
+			}
+			const genericNeuronState& n = brain.genericBank.pool.at(index);
+			if (n.input != input[i] || n.neuronCharge != charge[i]) {
+				mismatched++;
+			}
+		}
+		return mismatched;
+	}
+
+	size_t saturatedCount() const {
+		return static_cast<size_t>(std::count(saturated.begin(), saturated.end(), 1));
+	}
+
+	double bytesPerNeuron() const {
+		//input, incoming, charge, threshold, exhaustion, canFire, fired, CSR offset, brain ref
+		return 2 + 2 + 2 + 2 + 1 + 1 + 1 + 4 + 4;
+	}
+
+	double bytesPerSynapse() const {
+		return sizeof(uint32_t) + sizeof(int16_t);
+	}
+
+	size_t neuronCount() const {
+		return globalRefs.size();
+	}
+
+private:
+	std::vector<uint32_t> globalRefs;
+
+	std::vector<int16_t> input;
+	std::vector<int16_t> incoming;		//spikes for next tick
+	std::vector<int16_t> charge;
+	std::vector<int16_t> threshold;		//fire threshold already adjusted for fan in
+	std::vector<uint8_t> exhaustion;
+	std::vector<uint8_t> canFire;
+	std::vector<uint8_t> fired;
+	std::vector<uint8_t> saturated;		//input clipped at some point, see countStateMismatches
+
+	std::vector<uint32_t> childOffsets;
+	std::vector<uint32_t> childTargets;
+	std::vector<int16_t> childStrengths;
+};
+
+struct quantizationReport {
+	uint64_t ticks = 0;
+	uint64_t referenceSpikes = 0;
+	uint64_t fixedSpikes = 0;
+	uint64_t mismatchedSpikes = 0;		//fired in one engine but not the other
+	int64_t firstDivergence = -1;		//first tick with a mismatch, -1 if none
+	uint64_t mismatchedStates = 0;		//neurons with a different input or charge after the last tick
+	uint64_t saturatedNeurons = 0;		//inputs that clipped at the int16 limits, not compared
+};
+
+//runs the brain and a fixed point copy side by side for ticks ticks and compares the generic
+//spike trains tick by tick. floatReference runs the brain on the float input formula, which
+//measures what quantizing to integers costs, otherwise both sides use the integer formula and
+//have to agree exactly. the brain is advanced as a side effect
+quantizationReport validateFixedPoint(uint64_t ticks, bool floatReference) {
+	fixedPointEngine fixed;
+	fixed.build();
+	floatInputReference = floatReference;
+
+	quantizationReport report;
+	std::vector<uint32_t> referenceFired;
+	std::vector<uint32_t> fixedFired;
+
+	for (uint64_t t = 0; t < ticks; t++) {
+		referenceFired.clear();
+		fixedFired.clear();
+
+		tick(&referenceFired);
+		fixed.tick(&fixedFired);
+
+		referenceFired.erase(std::remove_if(referenceFired.begin(), referenceFired.end(), [](uint32_t ref) {
+			return neuronRefType(ref) != NeuronType::generic;
+		}), referenceFired.end());
+		std::sort(referenceFired.begin(), referenceFired.end());
+		std::sort(fixedFired.begin(), fixedFired.end());
+
+		std::vector<uint32_t> difference;
+		std::set_symmetric_difference(referenceFired.begin(), referenceFired.end(),
+			fixedFired.begin(), fixedFired.end(), std::back_inserter(difference));
+
+		report.ticks++;
+		report.referenceSpikes += referenceFired.size();
+		report.fixedSpikes += fixedFired.size();
+		report.mismatchedSpikes += difference.size();
+		if (!difference.empty() && report.firstDivergence < 0) {
+			report.firstDivergence = static_cast<int64_t>(t);
+		}
+	}
+	floatInputReference = false;
+	report.mismatchedStates = fixed.countStateMismatches();
+	report.saturatedNeurons = fixed.saturatedCount();
+	return report;
+}
+
+void printQuantizationReport(const quantizationReport& r) {
+	std::printf("fixed point over %llu ticks: %llu reference spikes, %llu fixed spikes, %llu mismatched",
+		static_cast<unsigned long long>(r.ticks), static_cast<unsigned long long>(r.referenceSpikes),
+		static_cast<unsigned long long>(r.fixedSpikes), static_cast<unsigned long long>(r.mismatchedSpikes));
+	if (r.firstDivergence >= 0) {
+		std::printf(", first divergence at tick %lld", static_cast<long long>(r.firstDivergence));
+	}
+	std::printf(", %llu neuron states differ at the end (%llu saturated, not compared)\n",
+		static_cast<unsigned long long>(r.mismatchedStates), static_cast<unsigned long long>(r.saturatedNeurons));
+}
+
+//-------------------------
+//population engine
+//runs many copies of the brain at once for reward sweeps. the topology (which synapse joins which
+//neurons, and synapse age) is compiled once and shared, each instance only owns its neuron state
+//and its synapse strengths. per instance values sit side by side, value [i * instances + lane],
+//so one walk over the adjacency updates every instance with the lane loop innermost where the
+//compiler can vectorize it. state uses the same int16 layout as the fixed point engine.
+//age is shared because every instance is rewarded on the same steps, only the amounts differ.
+//a lane with default settings follows the single process engine exactly as long as no input clips at the
+//int16 limits, both use the integer calculateInput. checkPopulation tests that
+
+//one instance's reward hyperparameters, the defaults match calculateReward and rewardSynapse
+struct rewardSettings {
+	int strongAmount = 2;		//reward agrees with the tally
+	int weakAmount = 1;
+	int youngMultiplier = 20;	//age < 5
+	int middleMultiplier = 5;	//age < 20
+	int oldMultiplier = 2;		//age < 100, older synapses don't move
+};
+
+class populationEngine {
+public:
+
+	//one instance per entry in settings, all starting from the brain as it is now
+	void build(const std::vector<rewardSettings>& settings) {
+		std::shared_lock<std::shared_mutex> neuronLock(neuronMapMutex);
+		std::shared_lock<std::shared_mutex> synapseLock(synapseMapMutex);
+		epochGuard guard;
+
+		lanes = settings;
+		instances = lanes.size();
+		rewardValues.assign(instances, 0);
+
+		globalRefs.clear();
+		denseOf.clear();
+		brain.genericBank.pool.forEach([&](uint32_t index, genericNeuronState&) {
+			denseOf[makeNeuronRef(NeuronType::generic, index)] = static_cast<uint32_t>(globalRefs.size());
+			globalRefs.push_back(makeNeuronRef(NeuronType::generic, index));
+		});
+		genericCount = globalRefs.size();
+		brain.rewardBank.pool.forEach([&](uint32_t index, rewardNeuronState&) {
+			denseOf[makeNeuronRef(NeuronType::reward, index)] = static_cast<uint32_t>(globalRefs.size());
+			globalRefs.push_back(makeNeuronRef(NeuronType::reward, index));
+		});
+		size_t rewardCount = globalRefs.size() - genericCount;
+
+		//shared topology
+		threshold.assign(genericCount, 0);
+		rewardFireThreshold.assign(rewardCount, 0);
+		rewardReverseThreshold.assign(rewardCount, 0);
+		childOffsets.assign(genericCount + 1, 0);
+		childTargets.clear();
+		edgeSynapses.clear();
+		edgeAges.clear();
+
+		//per instance state
+		input.assign(globalRefs.size() * instances, 0);
+		incoming.assign(globalRefs.size() * instances, 0);
+		charge.assign(genericCount * instances, -65);
+		exhaustion.assign(genericCount * instances, 0);
+		canFire.assign(genericCount * instances, 1);
+		fired.assign(genericCount * instances, 0);
+		anyFired.assign(genericCount, 0);
+		rewardCooldown.assign(rewardCount * instances, 0);
+		strengths.clear();
+
+		for (uint32_t i = 0; i < genericCount; i++) {
+			genericNeuronState& n = brain.genericBank.pool.at(neuronRefIndex(globalRefs[i]));
+
+			threshold[i] = saturate16(adjustThreshold(n.fireThreshold, n.fanIn.load()));
+			for (size_t k = 0; k < instances; k++) {
+				input[i * instances + k] = saturate16(n.input);
+				charge[i * instances + k] = saturate16(static_cast<int>(n.neuronCharge));
+				exhaustion[i * instances + k] = static_cast<uint8_t>(std::min(255, n.exhaustionLevel));
+				canFire[i * instances + k] = n.canFire ? 1 : 0;
+			}
+
+			for (uint32_t synapseIndex : n.childSynapses.read()) {
+				const Synapse& syn = brain.synapsePool.at(synapseIndex);
+				auto target = denseOf.find(syn.childNeuron);
+				if (target == denseOf.end()) {
+					continue;
+				}
+				childTargets.push_back(target->second);
+				edgeSynapses.push_back(synapseIndex);
+				edgeAges.push_back(syn.age);
+				strengths.insert(strengths.end(), instances, syn.strength);
+			}
+			childOffsets[i + 1] = static_cast<uint32_t>(childTargets.size());
+		}
+
+		for (size_t r = 0; r < rewardCount; r++) {
+			rewardNeuronState& n = brain.rewardBank.pool.at(neuronRefIndex(globalRefs[genericCount + r]));
+			rewardFireThreshold[r] = n.fireThreshold;
+			rewardReverseThreshold[r] = n.reverseThreshold;
+			for (size_t k = 0; k < instances; k++) {
+				input[(genericCount + r) * instances + k] = saturate16(n.input);
+				rewardCooldown[r * instances + k] = n.cooldown;
+			}
+		}
+
+		std::lock_guard<std::mutex> lock(spikeQueueMute);
+		for (const queuedSpike& spike : spikeQueue) {
+			auto target = denseOf.find(spike.childNeuron);
+			if (target == denseOf.end()) {
+				continue;
+			}
+			for (size_t k = 0; k < instances; k++) {
+				int16_t& slot = incoming[target->second * instances + k];
+				slot = saturate16(slot + fixedInput(spike.strength));
+			}
+		}
+	}
+
+	//adds input to one neuron, in every instance or only in lane
+	void injectInput(uint32_t neuronRef, int amount) {
+		auto target = denseOf.find(neuronRef);
+		if (target == denseOf.end()) {
+			return;
+		}
+		for (size_t k = 0; k < instances; k++) {
+			int16_t& slot = input[target->second * instances + k];
+			slot = saturate16(slot + amount);
+		}
+	}
+
+	void injectInput(uint32_t neuronRef, size_t lane, int amount) {
+		auto target = denseOf.find(neuronRef);
+		if (target == denseOf.end() || lane >= instances) {
+			return;
+		}
+		int16_t& slot = input[target->second * instances + lane];
+		slot = saturate16(slot + amount);
+	}
+
+	void tick() {
+		const size_t K = instances;
+
+		for (size_t i = 0; i < input.size(); i++) {
+			input[i] = saturate16(input[i] + incoming[i]);
+			incoming[i] = 0;
+		}
+
+		//generic neurons, same steps as fixedPointEngine::tick with the lane loop inside
+		for (size_t i = 0; i < genericCount; i++) {
+			int16_t* in = &input[i * K];
+			int16_t* c = &charge[i * K];
+			uint8_t* e = &exhaustion[i * K];
+			uint8_t* can = &canFire[i * K];
+			uint8_t* f = &fired[i * K];
+			int limit = threshold[i];
+			uint8_t any = 0;
+
+			for (size_t k = 0; k < K; k++) {
+				int x = in[k];
+				int q = c[k];
+				int ex = e[k];
+
+				bool fire = (q + x > limit) & (can[k] != 0);
+				in[k] = static_cast<int16_t>(x > 95 ? x - 95 : 0);
+
+				int firedCharge = q == -65 ? -80 : -(80 + ex);
+				int firedExhaustion = q == -65 ? 1 : ex + 1;
+				int restingCharge = q < -67 ? q + 2 : (q > -63 ? q - 2 : -65);
+
+				c[k] = static_cast<int16_t>(fire ? firedCharge : restingCharge);
+				e[k] = static_cast<uint8_t>(std::min(255, fire ? firedExhaustion : (restingCharge == -65 ? 0 : ex)));
+				can[k] = static_cast<uint8_t>(fire ? (firedCharge >= -90) : (restingCharge == -65 ? 1 : can[k]));
+				f[k] = fire;
+				any |= static_cast<uint8_t>(fire);
+			}
+			anyFired[i] = any;
+		}
+
+		//delivery, parents that stayed quiet in every instance are skipped whole
+		for (size_t i = 0; i < genericCount; i++) {
+			if (!anyFired[i]) {
+				continue;
+			}
+			const uint8_t* f = &fired[i * K];
+			for (uint32_t edge = childOffsets[i]; edge < childOffsets[i + 1]; edge++) {
+				int16_t* target = &incoming[childTargets[edge] * K];
+				const int16_t* w = &strengths[edge * K];
+				for (size_t k = 0; k < K; k++) {
+					target[k] = saturate16(target[k] + (f[k] ? fixedInput(w[k]) : 0));
+				}
+			}
+		}
+
+		//reward neurons, a handful at most so this stays scalar
+		for (size_t r = 0; r < rewardFireThreshold.size(); r++) {
+			for (size_t k = 0; k < K; k++) {
+				int16_t& in = input[(genericCount + r) * K + k];
+				int& cooldown = rewardCooldown[r * K + k];
+
+				if (cooldown > 0) {
+					cooldown -= 1;
+					continue;
+				}
+				if (in > rewardFireThreshold[r]) {
+					rewardValues[k] += 1;
+					in = 0;
+					cooldown = 10;
+				}
+				else if (in < rewardReverseThreshold[r]) {
+					rewardValues[k] -= 1;
+					in = 0;
+					cooldown = 10;
+				}
+				else {
+					//mirrors rewardPolicy, which only keeps input below -2
+					if (in > 2) {
+						in -= 2;
+					}
+					if (in < -2) {
+						in += 2;
+					}
+					else {
+						in = 0;
+					}
+				}
+			}
+		}
+	}
+
+	//calculateReward for every instance, each against its own tally and settings
+	void applyReward(bool reward) {
+		const size_t K = instances;
+
+		//signed step per instance and age bucket, the sign flips again on negative synapses
+		std::vector<int> step[3];
+		for (auto& s : step) {
+			s.assign(K, 0);
+		}
+		for (size_t k = 0; k < K; k++) {
+			bool direction = reward;
+			int amount = lanes[k].weakAmount;
+			if ((reward && rewardValues[k] > 0) || (!reward && rewardValues[k] < 0)) {
+				amount = lanes[k].strongAmount;
+			}
+			else if (reward && rewardValues[k] <= -1) {
+				direction = !reward;
+			}
+			int sign = direction ? 1 : -1;
+			step[0][k] = sign * amount * lanes[k].youngMultiplier;
+			step[1][k] = sign * amount * lanes[k].middleMultiplier;
+			step[2][k] = sign * amount * lanes[k].oldMultiplier;
+		}
+
+		for (size_t edge = 0; edge < edgeAges.size(); edge++) {
+			uint8_t& age = edgeAges[edge];
+			if (age < 100) {
+				const int* s = step[age < 5 ? 0 : (age < 20 ? 1 : 2)].data();
+				int16_t* w = &strengths[edge * K];
+				for (size_t k = 0; k < K; k++) {
+					int v = w[k];
+					v += v < 0 ? -s[k] : s[k];
+					w[k] = static_cast<int16_t>(std::max(-1000, std::min(1000, v)));
+				}
+			}
+			if (age < 255) {
+				age++;
+			}
+		}
+	}
+
+	void resetRewardValues() {
+		std::fill(rewardValues.begin(), rewardValues.end(), 0);
+	}
+
+	//copies one instance back into the brain, usually the winner of a sweep.
+	//neuron state and strengths are written, spikes still in flight are dropped
+	void adoptInstance(size_t lane) {
+		if (lane >= instances) {
+			return;
+		}
+		const size_t K = instances;
+		std::shared_lock<std::shared_mutex> neuronLock(neuronMapMutex);
+		std::shared_lock<std::shared_mutex> synapseLock(synapseMapMutex);
+
+		for (size_t edge = 0; edge < edgeSynapses.size(); edge++) {
+			uint32_t index = edgeSynapses[edge];
+			if (!brain.synapsePool.isLive(index)) {
+				continue;
+			}
+			std::lock_guard<std::mutex> stripe(synapseStripe(index));
+			Synapse& syn = brain.synapsePool.at(index);
+			syn.strength = strengths[edge * K + lane];
+			syn.age = edgeAges[edge];
+		}
+
+		for (size_t i = 0; i < globalRefs.size(); i++) {
+			uint32_t index = neuronRefIndex(globalRefs[i]);
+			if (i < genericCount) {
+				if (!brain.genericBank.pool.isLive(index)) {
+					continue;
+				}
+				genericNeuronState& n = brain.genericBank.pool.at(index);
+				n.input = input[i * K + lane];
+				n.neuronCharge = charge[i * K + lane];
+				n.exhaustionLevel = exhaustion[i * K + lane];
+				n.canFire = canFire[i * K + lane] != 0;
+			}
+			else {
+				if (!brain.rewardBank.pool.isLive(index)) {
+					continue;
+				}
+				rewardNeuronState& n = brain.rewardBank.pool.at(index);
+				n.input = input[i * K + lane];
+				n.cooldown = rewardCooldown[(i - genericCount) * K + lane];
+			}
+		}
+		rewardValue = rewardValues[lane];
+	}
+
+	int16_t strength(size_t edge, size_t lane) const { return strengths[edge * instances + lane]; }
+	uint32_t edgeSynapse(size_t edge) const { return edgeSynapses[edge]; }
+	size_t edgeCount() const { return edgeSynapses.size(); }
+	int rewardTally(size_t lane) const { return rewardValues[lane]; }
+	size_t instanceCount() const { return instances; }
+
+	//topology is paid once, everything else once per instance
+	size_t sharedBytes() const {
+		return childOffsets.capacity() * sizeof(uint32_t) + childTargets.capacity() * sizeof(uint32_t) +
+			edgeSynapses.capacity() * sizeof(uint32_t) + edgeAges.capacity() +
+			threshold.capacity() * sizeof(int16_t) + anyFired.capacity() +
+			globalRefs.capacity() * sizeof(uint32_t) +
+			denseOf.bucket_count() * sizeof(void*) + denseOf.size() * (2 * sizeof(uint32_t) + 2 * sizeof(void*));
+	}
+
+	size_t bytesPerInstance() const {
+		size_t neurons = globalRefs.size();
+		//input, incoming, charge, exhaustion, canFire, fired, reward cooldown, strengths
+		return neurons * 2 * sizeof(int16_t) + genericCount * (sizeof(int16_t) + 3) +
+			(neurons - genericCount) * sizeof(int) + edgeSynapses.size() * sizeof(int16_t);
+	}
+
+private:
+	std::vector<rewardSettings> lanes;
+	size_t instances = 0;
+	size_t genericCount = 0;		//dense indices below this are generic, the rest reward
+
+	//shared
+	std::vector<uint32_t> globalRefs;
+	std::unordered_map<uint32_t, uint32_t> denseOf;
+	std::vector<int16_t> threshold;
+	std::vector<int> rewardFireThreshold;
+	std::vector<int> rewardReverseThreshold;
+	std::vector<uint32_t> childOffsets;
+	std::vector<uint32_t> childTargets;
+	std::vector<uint32_t> edgeSynapses;
+	std::vector<uint8_t> edgeAges;
+	std::vector<uint8_t> anyFired;
+
+	//per instance, interleaved
+	std::vector<int16_t> input;
+	std::vector<int16_t> incoming;
+	std::vector<int16_t> charge;
+	std::vector<uint8_t> exhaustion;
+	std::vector<uint8_t> canFire;
+	std::vector<uint8_t> fired;
+	std::vector<int> rewardCooldown;
+	std::vector<int16_t> strengths;
+	std::vector<int> rewardValues;
+};
+
+void printPopulationReport(const populationEngine& population) {
+	std::printf("population of %zu: %zu shared bytes, %zu bytes per instance\n",
+		population.instanceCount(), population.sharedBytes(), population.bytesPerInstance());
+	for (size_t k = 0; k < population.instanceCount(); k++) {
+		std::printf("  instance %zu reward tally %d\n", k, population.rewardTally(k));
+	}
+}
+
+//-------------------------
+//sharded engine
+//space is cut into slabs along x, each owned by one worker with its own networkStore.
+//placement keeps new neurons near their seeds, so most synapses stay inside a shard.
+//a synapse lives in its parent's shard, when the child is elsewhere the synapse points at a
+//remote proxy and the spike crosses over through that shard pair's mailbox at the tick barrier
+
+//neuron ref type bits for a proxy, past the end of NeuronType
+constexpr uint32_t remoteNeuronType = 7;
+
+struct remoteNeuron {
+	uint32_t shard;
+	uint32_t neuronRef;		//ref inside the owning shard
+};
+
+struct crossSpike {
+	uint32_t neuronRef;
+	int strength;
+};
+
+//one per ordered shard pair, single producer single consumer
+//the source appends to writing during a tick, the barrier swaps, the destination drains reading next tick
+//so the two sides never touch the same buffer and no lock is needed
+struct spikeMailbox {
+	std::vector<crossSpike> writing;
+	std::vector<crossSpike> reading;
+
+	void exchange() {
+		reading.clear();
+		reading.swap(writing);
+	}
+};
+
+//reusable barrier, the last thread to arrive runs onComplete before anyone is released
+class tickBarrier {
+public:
+	tickBarrier(size_t count, std::function<void()> onComplete)
+		: count(count), onComplete(std::move(onComplete)) {}
+
+	void arriveAndWait() {
+		std::unique_lock<std::mutex> lock(barrierMute);
+		uint64_t arrivedGeneration = generation;
+		if (++waiting == count) {
+			onComplete();
+			waiting = 0;
+			generation++;
+			released.notify_all();
+		}
+		else {
+			released.wait(lock, [&] { return generation != arrivedGeneration; });
+		}
+	}
+
+private:
+	std::mutex barrierMute;
+	std::condition_variable released;
+	size_t count;
+	size_t waiting = 0;
+	uint64_t generation = 0;
+	std::function<void()> onComplete;
+};
+
+struct networkShard {
+	uint32_t id = 0;
+	long minX = 0;		//owns neurons with minX <= x < maxX
+	long maxX = 0;
+
+	networkStore store;
+	std::vector<remoteNeuron> remoteNeurons;	//proxy index -> owner
+
+	//brain ref <-> local ref and local -> brain synapse index, only used to build, sync and rebalance
+	std::unordered_map<uint32_t, uint32_t> localNeuronRefs;
+	std::unordered_map<uint32_t, uint32_t> globalNeuronRefs;
+	std::vector<std::pair<uint32_t, uint32_t>> globalSynapses;	//(local, global)
+
+	std::vector<queuedSpike> pending;	//spikes for this shard's next tick
+	std::vector<queuedSpike> outgoing;
+
+	//since the last rebalance check: work is one per neuron per tick for the bank update plus one
+	//per delivered spike, received is the spike part per local neuron, by NeuronType then index.
+	//a neuron's share of work is ticks + received, rebuilds cut boundaries on that
+	uint64_t work = 0;
+	std::vector<uint64_t> received[2];
+};
+
+//one tick for one shard: delivers its pending spikes plus the cross shard ones in batch,
+//runs the banks, keeps local spikes for next tick and hands the rest to sendRemote(shard, spike)
+template <typename SendRemote>
+void stepShard(networkShard& shard, std::vector<queuedSpike>& batch, SendRemote&& sendRemote) {
+
+	batch.insert(batch.end(), shard.pending.begin(), shard.pending.end());
+	shard.pending.clear();
+
+	if (deterministicMode) {
+		sortSpikesCanonically(batch);
+	}
+	for (const queuedSpike& spike : batch) {
+		shard.store.pushToNeuron(spike.childNeuron, spike.strength);
+		uint32_t type = static_cast<uint32_t>(neuronRefType(spike.childNeuron));
+		uint32_t index = neuronRefIndex(spike.childNeuron);
+		if (type < 2 && index < shard.received[type].size()) {
+			shard.received[type][index]++;
+		}
+	}
+	shard.work += batch.size() + shard.localNeuronRefs.size();
+
+	//the shard's worker is the only one touching its store, no synapse locks needed
+	shard.outgoing.clear();
+	shard.store.updateBanks(shard.outgoing, false);
+
+	for (const queuedSpike& spike : shard.outgoing) {
+		if (neuronRefType(spike.childNeuron) == static_cast<NeuronType>(remoteNeuronType)) {
+			const remoteNeuron& target = shard.remoteNeurons[neuronRefIndex(spike.childNeuron)];
+			sendRemote(target.shard, crossSpike{ target.neuronRef, spike.strength });
+		}
+		else {
+			shard.pending.push_back(spike);
+		}
+	}
+}
+
+class shardedEngine {
+public:
+
+	//partitions the global brain into shardCount x slabs with about the same work each. work per
+	//neuron is measured by the shards being replaced, a first build or a neuron that is new since
+	//counts every neuron the same. each shard's storage is built on its own thread so first touch
+	//puts it near that worker.
+	//spikes waiting in the global spikeQueue move into the shard that owns their target.
+	//shards are copies: neurons and synapses created or pruned in the global brain afterwards
+	//(createNeuron, createSynapse, growth, pruneSynapses) only reach the shards through a rebuild
+	void build(size_t shardCount);
+
+	//runs ticks with one worker per shard. if the global brain's structure changed since build,
+	//the shards are synced and rebuilt first, the same way rebalance does. after syncToBrain the
+	//brain owns the network again and the shards are rebuilt from it. once rebalanceCheckTicks
+	//ticks of work have been measured, uneven shards are rebalanced and the measure starts over
+	void run(uint64_t ticks);
+
+	uint64_t rebalanceCheckTicks = 100;		//0 never checks
+	double rebalanceTolerance = 1.5;
+
+	//true when the global brain gained or lost neurons or synapses since build
+	bool stale() const {
+		return builtVersion != networkVersion.load();
+	}
+
+	//hands the network back to the global brain: neuron and synapse state are copied back and
+	//spikes still in flight, pending in a shard or in a mailbox, go back into spikeQueue. the
+	//global tick() carries on exactly where the shards stopped
+	void syncToBrain();
+
+	//true when the busiest shard did more than tolerance times the average work
+	bool needsRebalance(double tolerance = 1.5) const;
+
+	//recomputes the slab boundaries from the work measured so far and rebuilds the shards
+	void rebalance();
+
+	//starts a new measuring window for needsRebalance and the next rebuild
+	void resetWork();
+
+	size_t shardCount() const {
+		return shards.size();
+	}
+
+	networkShard& shard(size_t i) {
+		return *shards[i];
+	}
+
+	//frees every shard but one, for a process that only runs its own partition
+	void releaseAllBut(size_t keep) {
+		for (size_t i = 0; i < shards.size(); i++) {
+			if (i != keep) {
+				shards[i]->store.clear();
+			}
+		}
+	}
+
+private:
+	spikeMailbox& mailbox(uint32_t from, uint32_t to) {
+		return mailboxes[static_cast<size_t>(from) * shards.size() + to];
+	}
+
+	uint32_t ownerOf(long x) const {
+		//boundaries holds the minX of every shard after the first
+		return static_cast<uint32_t>(std::upper_bound(boundaries.begin(), boundaries.end(), x) - boundaries.begin());
+	}
+
+	void step(networkShard& shard);
+
+	std::vector<std::unique_ptr<networkShard>> shards;
+	std::vector<long> boundaries;
+	std::vector<spikeMailbox> mailboxes;
+	uint64_t builtVersion = 0;
+	bool handedBack = false;	//set by syncToBrain, the shards' state is the brain's until rebuilt
+	uint64_t ticksSinceCheck = 0;
+};
+
+void shardedEngine::build(size_t shardCount) {
+
+	std::shared_lock<std::shared_mutex> neuronLock(neuronMapMutex);
+	std::shared_lock<std::shared_mutex> synapseLock(synapseMapMutex);
+	builtVersion = networkVersion.load();
+	handedBack = false;
+
+	shardCount = std::max<size_t>(1, shardCount);
+
+	//work per neuron as the old shards measured it, by global ref
+	std::unordered_map<uint32_t, uint64_t> measured;
+	for (auto& shard : shards) {
+		for (const auto& pair : shard->globalNeuronRefs) {
+			uint32_t type = static_cast<uint32_t>(neuronRefType(pair.first));
+			uint32_t index = neuronRefIndex(pair.first);
+			uint64_t spikes = type < 2 && index < shard->received[type].size() ? shard->received[type][index] : 0;
+			measured[pair.second] = ticksSinceCheck + spikes;
+		}
+	}
+
+	//work weighted x quantiles of the current neuron positions
+	std::vector<std::pair<long, uint64_t>> xs;
+	brain.forEachBank([&](auto& bank) {
+		using policy = typename std::decay_t<decltype(bank)>::policy;
+		bank.pool.forEach([&](uint32_t index, typename policy::state& n) {
+			auto found = measured.find(makeNeuronRef(policy::type, index));
+			uint64_t weight = std::max<uint64_t>(1, found == measured.end() ? ticksSinceCheck : found->second);
+			xs.push_back({ n.positionData.Position.x, weight });
+		});
+	});
+	std::sort(xs.begin(), xs.end());
+	uint64_t totalWork = 0;
+	for (const auto& x : xs) {
+		totalWork += x.second;
+	}
+
+	//shard i starts at the first neuron with at least i / shardCount of the work before it
+	boundaries.clear();
+	uint64_t before = 0;
+	size_t next = 0;
+	for (size_t i = 1; i < shardCount; i++) {
+		uint64_t target = totalWork * i / shardCount;
+		while (next < xs.size() && before < target) {
+			before += xs[next].second;
+			next++;
+		}
+		boundaries.push_back(xs.empty() ? 0 : xs[std::min(next, xs.size() - 1)].first);
+	}
+	ticksSinceCheck = 0;
+
+	shards.clear();
+	for (size_t i = 0; i < shardCount; i++) {
+		auto shard = std::make_unique<networkShard>();
+		shard->id = static_cast<uint32_t>(i);
+		shard->minX = i == 0 ? std::numeric_limits<long>::min() : boundaries[i - 1];
+		shard->maxX = i + 1 == shardCount ? std::numeric_limits<long>::max() : boundaries[i];
+		shards.push_back(std::move(shard));
+	}
+	mailboxes.clear();
+	mailboxes.resize(shardCount * shardCount);
+
+	//work lists per shard, built up front so each worker only ever writes its own store
+	std::vector<std::vector<uint32_t>> ownedNeurons(shardCount);
+	brain.forEachBank([&](auto& bank) {
+		using policy = typename std::decay_t<decltype(bank)>::policy;
+		bank.pool.forEach([&](uint32_t index, typename policy::state& n) {
+			ownedNeurons[ownerOf(n.positionData.Position.x)].push_back(makeNeuronRef(policy::type, index));
+		});
+	});
+
+	auto shardOfRef = [this](uint32_t ref) {
+		uint32_t owner = 0;
+		brain.visitNeuron(ref, [&](auto& bank, uint32_t index) {
+			owner = ownerOf(bank.pool.at(index).positionData.Position.x);
+		});
+		return owner;
+	};
+
+	//(parent ref, synapse index) per parent's shard, walked from the parents since synapses
+	//don't record theirs
+	std::vector<std::vector<std::pair<uint32_t, uint32_t>>> outgoingSynapses(shardCount);
+	std::vector<std::vector<uint32_t>> incomingRemote(shardCount);
+	{
+		epochGuard guard;
+		for (uint32_t from = 0; from < shardCount; from++) {
+			for (uint32_t parentRef : ownedNeurons[from]) {
+				brain.visitNeuron(parentRef, [&](auto& bank, uint32_t index) {
+					for (uint32_t synapseIndex : bank.pool.at(index).childSynapses.read()) {
+						uint32_t to = shardOfRef(brain.synapsePool.at(synapseIndex).childNeuron);
+						outgoingSynapses[from].push_back({ parentRef, synapseIndex });
+						if (from != to) {
+							incomingRemote[to].push_back(synapseIndex);
+						}
+					}
+				});
+			}
+		}
+	}
+
+	//phase one, neurons. local refs have to exist everywhere before synapses can point at them
+	auto parallel = [shardCount](auto&& f) {
+		std::vector<std::thread> workers;
+		for (size_t i = 0; i < shardCount; i++) {
+			workers.emplace_back(f, static_cast<uint32_t>(i));
+		}
+		for (std::thread& t : workers) {
+			t.join();
+		}
+	};
+
+	parallel([&](uint32_t i) {
+		networkShard& shard = *shards[i];
+		for (uint32_t globalRef : ownedNeurons[i]) {
+			brain.visitNeuron(globalRef, [&](auto& bank, uint32_t index) {
+				using policy = typename std::decay_t<decltype(bank)>::policy;
+				auto& localBank = shard.store.bankFor<policy>();
+				uint32_t localIndex = localBank.pool.create().index;
+				policy::copyState(localBank.pool.at(localIndex), bank.pool.at(index));
+				uint32_t localRef = makeNeuronRef(policy::type, localIndex);
+				std::vector<uint64_t>& received = shard.received[static_cast<uint32_t>(policy::type) & 1];
+				if (localIndex >= received.size()) {
+					received.resize(localIndex + 1, 0);
+				}
+				shard.localNeuronRefs[globalRef] = localRef;
+				shard.globalNeuronRefs[localRef] = globalRef;
+			});
+		}
+	});
+
+	//phase two, synapses in the parent's shard, proxies for children elsewhere
+	parallel([&](uint32_t i) {
+		networkShard& shard = *shards[i];
+		std::unordered_map<uint64_t, uint32_t> proxies;	//(shard << 32 | ref) -> proxy index
+
+		for (const auto& outgoing : outgoingSynapses[i]) {
+			uint32_t globalIndex = outgoing.second;
+			const Synapse& syn = brain.synapsePool.at(globalIndex);
+			uint32_t childShard = shardOfRef(syn.childNeuron);
+			uint32_t childLocal = shards[childShard]->localNeuronRefs.at(syn.childNeuron);
+
+			uint32_t childRef = childLocal;
+			if (childShard != i) {
+				uint64_t key = (static_cast<uint64_t>(childShard) << 32) | childLocal;
+				auto found = proxies.find(key);
+				if (found == proxies.end()) {
+					found = proxies.emplace(key, static_cast<uint32_t>(shard.remoteNeurons.size())).first;
+					shard.remoteNeurons.push_back({ childShard, childLocal });
+				}
+				childRef = makeNeuronRef(static_cast<NeuronType>(remoteNeuronType), found->second);
+			}
+
+			uint32_t localIndex = shard.store.synapsePool.create().index;
+			Synapse& local = shard.store.synapsePool.at(localIndex);
+			local = syn;
+			local.childNeuron = childRef;
+			shard.globalSynapses.push_back({ localIndex, globalIndex });
+
+			shard.store.visitNeuron(shard.localNeuronRefs.at(outgoing.first), [localIndex](auto& bank, uint32_t index) {
+				bank.pool.at(index).childSynapses.append(localIndex);
+			});
+			if (childShard == i) {
+				shard.store.visitNeuron(childRef, [](auto& bank, uint32_t index) {
+					bank.pool.at(index).fanIn++;
+				});
+			}
+		}
+
+		//remote parents only count towards fan in here, their synapse lives in the other shard
+		for (uint32_t globalIndex : incomingRemote[i]) {
+			const Synapse& syn = brain.synapsePool.at(globalIndex);
+			shard.store.visitNeuron(shard.localNeuronRefs.at(syn.childNeuron), [](auto& bank, uint32_t index) {
+				bank.pool.at(index).fanIn++;
+			});
+		}
+	});
+
+	//spikes queued for the global brain's next tick are this engine's now
+	std::lock_guard<std::mutex> queueLock(spikeQueueMute);
+	for (const queuedSpike& spike : spikeQueue) {
+		if (!brain.neuronLive(spike.childNeuron)) {
+			continue;
+		}
+		networkShard& owner = *shards[shardOfRef(spike.childNeuron)];
+		owner.pending.push_back({ owner.localNeuronRefs.at(spike.childNeuron), noSynapse, spike.strength });
+	}
+	spikeQueue.clear();
+}
+
+void shardedEngine::step(networkShard& shard) {
+
+	std::vector<queuedSpike> batch;
+	for (uint32_t from = 0; from < shards.size(); from++) {
+		for (const crossSpike& spike : mailbox(from, shard.id).reading) {
+			batch.push_back({ spike.neuronRef, noSynapse, spike.strength });
+		}
+	}
+
+	stepShard(shard, batch, [this, &shard](uint32_t to, const crossSpike& spike) {
+		mailbox(shard.id, to).writing.push_back(spike);
+	});
+}
+
+void shardedEngine::run(uint64_t ticks) {
+
+	if (handedBack) {
+		build(shards.size());
+	}
+	else if (stale()) {
+		rebalance();
+	}
+	else if (rebalanceCheckTicks > 0 && ticksSinceCheck >= rebalanceCheckTicks) {
+		if (needsRebalance(rebalanceTolerance)) {
+			rebalance();
+		}
+		else {
+			resetWork();
+		}
+	}
+	ticksSinceCheck += ticks;
+
+	tickBarrier barrier(shards.size(), [this]() {
+		for (spikeMailbox& box : mailboxes) {
+			box.exchange();
+		}
+		clockState = !clockState;
+		tickCount++;
+	});
+
+	std::vector<std::thread> workers;
+	for (auto& shard : shards) {
+		networkShard* owned = shard.get();
+		workers.emplace_back([this, owned, &barrier, ticks]() {
+			for (uint64_t t = 0; t < ticks; t++) {
+				step(*owned);
+				barrier.arriveAndWait();
+			}
+		});
+	}
+	for (std::thread& t : workers) {
+		t.join();
+	}
+}
+
+void shardedEngine::syncToBrain() {
+
+	//already handed back, the brain may have moved on since
+	if (handedBack) {
+		return;
+	}
+
+	std::shared_lock<std::shared_mutex> neuronLock(neuronMapMutex);
+	std::shared_lock<std::shared_mutex> synapseLock(synapseMapMutex);
+
+	//in flight spikes by global ref. pending ones use this shard's local refs, mailbox ones the
+	//receiving shard's. after a run the barrier has already swapped everything into reading
+	std::vector<queuedSpike> inFlight;
+	for (auto& shard : shards) {
+		for (const queuedSpike& spike : shard->pending) {
+			inFlight.push_back({ shard->globalNeuronRefs.at(spike.childNeuron), noSynapse, spike.strength });
+		}
+		shard->pending.clear();
+		for (uint32_t to = 0; to < shards.size(); to++) {
+			spikeMailbox& box = mailbox(shard->id, to);
+			for (const crossSpike& spike : box.writing) {
+				inFlight.push_back({ shards[to]->globalNeuronRefs.at(spike.neuronRef), noSynapse, spike.strength });
+			}
+			for (const crossSpike& spike : box.reading) {
+				inFlight.push_back({ shards[to]->globalNeuronRefs.at(spike.neuronRef), noSynapse, spike.strength });
+			}
+			box.writing.clear();
+			box.reading.clear();
+		}
+	}
+	{
+		std::lock_guard<std::mutex> lock(spikeQueueMute);
+		for (const queuedSpike& spike : inFlight) {
+			if (brain.neuronLive(spike.childNeuron)) {
+				spikeQueue.push_back(spike);
+			}
+		}
+	}
+	handedBack = true;
+
+	for (auto& shard : shards) {
+		for (const auto& pair : shard->globalNeuronRefs) {
+			shard->store.visitNeuron(pair.first, [&](auto& bank, uint32_t index) {
+				using policy = typename std::decay_t<decltype(bank)>::policy;
+				auto& globalBank = brain.bankFor<policy>();
+				uint32_t globalIndex = neuronRefIndex(pair.second);
+				if (globalBank.pool.isLive(globalIndex)) {
+					policy::copyState(globalBank.pool.at(globalIndex), bank.pool.at(index));
+				}
+			});
+		}
+		for (const auto& pair : shard->globalSynapses) {
+			const Synapse& local = shard->store.synapsePool.at(pair.first);
+			if (!brain.synapsePool.isLive(pair.second)) {
+				continue;
+			}
+			std::lock_guard<std::mutex> stripe(synapseStripe(pair.second));
+			Synapse& global = brain.synapsePool.at(pair.second);
+			global.strength = local.strength;
+			global.age = local.age;
+			global.idleSweeps = local.idleSweeps;
+			global.weakSweeps = local.weakSweeps;
+		}
+	}
+}
+
+bool shardedEngine::needsRebalance(double tolerance) const {
+	if (shards.size() < 2) {
+		return false;
+	}
+	uint64_t total = 0;
+	uint64_t busiest = 0;
+	for (const auto& shard : shards) {
+		total += shard->work;
+		busiest = std::max(busiest, shard->work);
+	}
+	double mean = double(total) / shards.size();
+	return mean > 0 && busiest > mean * tolerance;
+}
+
+void shardedEngine::resetWork() {
+	for (auto& shard : shards) {
+		shard->work = 0;
+		for (std::vector<uint64_t>& received : shard->received) {
+			std::fill(received.begin(), received.end(), 0);
+		}
+	}
+	ticksSinceCheck = 0;
+}
+
+void shardedEngine::rebalance() {
+
+	//a full sync and rebuild, shards don't track their own structural changes so there is nothing
+	//smaller to apply. in flight spikes go through spikeQueue, which build takes back
+	syncToBrain();
+	build(shards.size());
+}
+
+//-------------------------
+//multi-process runtime
+//one brain split across processes on one host. every process builds the same shard layout,
+//keeps only its own shard and runs it, boundary spikes go through a spikeTransport once per tick.
+//a coordinator process drives the tick barrier through a small shared control block.
+//a rank that dies, fails to connect or overruns tickTimeoutMs aborts the run: every wait checks
+//the shared abort flag and the coordinator kills whatever is left after shutdownGraceMs.
+//POSIX only for now, and each process still starts from the full brain before dropping the other shards
+
+#if !defined(_WIN32)
+
+constexpr uint32_t maxPartitions = 64;
+constexpr uint64_t stopTick = ~0ull;
+
+//how long a partitioned run waits on a rank before tearing everything down
+struct partitionSettings {
+	uint32_t tickTimeoutMs = 10000;		//longest one tick may take across all ranks
+	uint32_t connectTimeoutMs = 5000;	//socket transport setup
+	uint32_t shutdownGraceMs = 1000;	//after a failure, time for the other ranks to exit before they are killed
+};
+
+partitionSettings partitioning;
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "control block atomics are shared between processes");
+
+//written only by the owning rank, read by the coordinator after that rank reports the tick done
+struct partitionStats {
+	uint64_t ticks = 0;
+	uint64_t spikesSent = 0;
+	uint64_t spikesReceived = 0;
+	uint64_t lastTickSpikes = 0;		//sent plus received in the most recent tick
+	uint64_t stallNanos = 0;			//waiting on the coordinator or on peers' spikes
+	uint64_t maxTickStallNanos = 0;
+	uint64_t stateChecksum = 0;			//filled in when the run ends
+	int64_t rewardChange = 0;			//this rank's changes to rewardValue, summed by the coordinator
+};
+
+struct alignas(64) paddedTick {
+	std::atomic<uint64_t> value;
+};
+
+struct partitionControl {
+	uint32_t processCount = 0;
+	paddedTick goTick;						//coordinator -> workers, highest tick allowed to run
+	paddedTick doneTick[maxPartitions];		//workers -> coordinator
+	partitionStats stats[maxPartitions];
+	std::atomic<uint32_t> aborted{ 0 };		//set by any process when the run can't finish, every wait checks it
+	std::atomic<int64_t> rewardTotal{ 0 };	//rewardValue across all ranks as of the last finished tick
+};
+
+uint64_t nanosSince(std::chrono::steady_clock::time_point start) {
+	return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now() - start).count());
+}
+
+//a named POSIX shared memory mapping, the creator unlinks it when done
+class sharedRegion {
+public:
+	sharedRegion() = default;
+	sharedRegion(const sharedRegion&) = delete;
+	sharedRegion& operator=(const sharedRegion&) = delete;
+
+	~sharedRegion() {
+		if (base != nullptr) {
+			munmap(base, size);
+		}
+		if (owner) {
+			shm_unlink(name.c_str());
+		}
+	}
+
+	//new zeroed region, name has to start with '/'
+	bool create(const std::string& regionName, size_t bytes) {
+		shm_unlink(regionName.c_str());
+		int fd = shm_open(regionName.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+		if (fd < 0) {
+			return false;
+		}
+		if (ftruncate(fd, static_cast<off_t>(bytes)) != 0) {
+			close(fd);
+			shm_unlink(regionName.c_str());
+			return false;
+		}
+		owner = true;
+		return map(fd, regionName, bytes);
+	}
+
+	//region made by another process
+	bool open(const std::string& regionName, size_t bytes) {
+		int fd = shm_open(regionName.c_str(), O_RDWR, 0600);
+		if (fd < 0) {
+			return false;
+		}
+		return map(fd, regionName, bytes);
+	}
+
+	void* data() const {
+		return base;
+	}
+
+private:
+	bool map(int fd, const std::string& regionName, size_t bytes) {
+		void* mapped = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+		close(fd);
+		if (mapped == MAP_FAILED) {
+			return false;
+		}
+		base = mapped;
+		size = bytes;
+		name = regionName;
+		return true;
+	}
+
+	std::string name;
+	void* base = nullptr;
+	size_t size = 0;
+	bool owner = false;
+};
+
+class spikeTransport {
+public:
+	virtual ~spikeTransport() = default;
+
+	//sends outbound[peer] to every other rank and returns once every peer's spikes for this tick are in inbound
+	//returns the nanoseconds spent blocked on peers. gives up early, with broken set, when a peer
+	//goes away or abortFlag is raised
+	virtual uint64_t exchange(uint64_t tick, const std::vector<std::vector<crossSpike>>& outbound,
+		std::vector<crossSpike>& inbound) = 0;
+
+	const std::atomic<uint32_t>* abortFlag = nullptr;
+	bool broken = false;
+
+protected:
+	bool aborted() const {
+		return abortFlag != nullptr && abortFlag->load(std::memory_order_acquire) != 0;
+	}
+};
+
+//one SPSC ring per ordered rank pair in a shared region
+//the producer publishes sentTick after its last spike for a tick, so the consumer knows when it has them all
+struct spikeRingHeader {
+	alignas(64) std::atomic<uint64_t> head;		//consumer position
+	alignas(64) std::atomic<uint64_t> tail;		//producer position
+	alignas(64) std::atomic<uint64_t> sentTick;
+};
+
+class sharedMemoryTransport : public spikeTransport {
+public:
+	static constexpr uint32_t defaultCapacity = 1u << 16;
+
+	static size_t ringBytes(uint32_t capacity) {
+		size_t bytes = sizeof(spikeRingHeader) + static_cast<size_t>(capacity) * sizeof(crossSpike);
+		return (bytes + 63) & ~static_cast<size_t>(63);
+	}
+
+	static size_t regionBytes(uint32_t processCount, uint32_t capacity) {
+		return static_cast<size_t>(processCount) * processCount * ringBytes(capacity);
+	}
+
+	//run once by whoever created the region
+	static void initialize(void* region, uint32_t processCount, uint32_t capacity) {
+		for (size_t i = 0; i < static_cast<size_t>(processCount) * processCount; i++) {
+			new (static_cast<char*>(region) + i * ringBytes(capacity)) spikeRingHeader{};
+		}
+	}
+
+	sharedMemoryTransport(void* region, uint32_t processCount, uint32_t capacity, uint32_t rank)
+		: region(static_cast<char*>(region)), processCount(processCount), capacity(capacity), rank(rank) {}
+
+	uint64_t exchange(uint64_t tick, const std::vector<std::vector<crossSpike>>& outbound,
+		std::vector<crossSpike>& inbound) override {
+
+		uint64_t stall = 0;
+
+		//push everything, draining our own inbound rings while a full ring waits on its reader
+		std::vector<size_t> offsets(processCount, 0);
+		bool sending = true;
+		while (sending) {
+			sending = false;
+			bool progress = false;
+			for (uint32_t peer = 0; peer < processCount; peer++) {
+				if (peer == rank) {
+					continue;
+				}
+				size_t before = offsets[peer];
+				offsets[peer] += push(rank, peer, outbound[peer], offsets[peer]);
+				progress |= offsets[peer] != before;
+				sending |= offsets[peer] < outbound[peer].size();
+			}
+			progress |= drainAll(inbound);
+			if (sending && !progress) {
+				if (aborted()) {
+					broken = true;
+					return stall;
+				}
+				auto waitStart = std::chrono::steady_clock::now();
+				std::this_thread::yield();
+				stall += nanosSince(waitStart);
+			}
+		}
+		for (uint32_t peer = 0; peer < processCount; peer++) {
+			if (peer != rank) {
+				ringHeader(rank, peer).sentTick.store(tick, std::memory_order_release);
+			}
+		}
+
+		auto waitStart = std::chrono::steady_clock::now();
+		while (true) {
+			bool allSent = true;
+			for (uint32_t peer = 0; peer < processCount; peer++) {
+				if (peer != rank && ringHeader(peer, rank).sentTick.load(std::memory_order_acquire) < tick) {
+					allSent = false;
+				}
+			}
+			//one more drain after the markers, they are published after the last spike
+			drainAll(inbound);
+			if (allSent) {
+				break;
+			}
+			//a dead peer never publishes its marker, the coordinator notices and raises the flag
+			if (aborted()) {
+				broken = true;
+				break;
+			}
+			std::this_thread::yield();
+		}
+		stall += nanosSince(waitStart);
+
+		return stall;
+	}
+
+private:
+	spikeRingHeader& ringHeader(uint32_t from, uint32_t to) {
+		return *reinterpret_cast<spikeRingHeader*>(region + (static_cast<size_t>(from) * processCount + to) * ringBytes(capacity));
+	}
+
+	crossSpike* ringSlots(uint32_t from, uint32_t to) {
+		return reinterpret_cast<crossSpike*>(reinterpret_cast<char*>(&ringHeader(from, to)) + sizeof(spikeRingHeader));
+	}
+
+	//returns how many spikes fit
+	size_t push(uint32_t from, uint32_t to, const std::vector<crossSpike>& spikes, size_t offset) {
+		spikeRingHeader& header = ringHeader(from, to);
+		uint64_t head = header.head.load(std::memory_order_acquire);
+		uint64_t tail = header.tail.load(std::memory_order_relaxed);
+		size_t room = capacity - static_cast<size_t>(tail - head);
+		size_t count = std::min(room, spikes.size() - offset);
+
+		crossSpike* slots = ringSlots(from, to);
+		for (size_t i = 0; i < count; i++) {
+			slots[(tail + i) % capacity] = spikes[offset + i];
+		}
+		header.tail.store(tail + count, std::memory_order_release);
+		return count;
+	}
+
+	bool drainAll(std::vector<crossSpike>& inbound) {
+		bool any = false;
+		for (uint32_t peer = 0; peer < processCount; peer++) {
+			if (peer == rank) {
+				continue;
+			}
+			spikeRingHeader& header = ringHeader(peer, rank);
+			uint64_t tail = header.tail.load(std::memory_order_acquire);
+			uint64_t head = header.head.load(std::memory_order_relaxed);
+			crossSpike* slots = ringSlots(peer, rank);
+			for (uint64_t i = head; i < tail; i++) {
+				inbound.push_back(slots[i % capacity]);
+			}
+			if (tail != head) {
+				header.head.store(tail, std::memory_order_release);
+				any = true;
+			}
+		}
+		return any;
+	}
+
+	char* region;
+	uint32_t processCount;
+	uint32_t capacity;
+	uint32_t rank;
+};
+
+//unix domain stream sockets between every rank pair
+//each tick every peer gets a uint32 count followed by that many spikes
+class socketTransport : public spikeTransport {
+public:
+	socketTransport() = default;
+	socketTransport(const socketTransport&) = delete;
+	socketTransport& operator=(const socketTransport&) = delete;
+
+	~socketTransport() {
+		for (int fd : peers) {
+			if (fd >= 0) {
+				close(fd);
+			}
+		}
+		if (!listenPath.empty()) {
+			unlink(listenPath.c_str());
+		}
+	}
+
+	//every rank listens on basePath.rank, connects to the ranks below it and accepts the ranks above.
+	//fails after timeoutMs, or as soon as abortFlag is raised by a rank that failed first
+	bool connectPeers(const std::string& basePath, uint32_t myRank, uint32_t processCount, uint32_t timeoutMs) {
+		rank = myRank;
+		auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+		auto expired = [this, deadline]() {
+			return aborted() || std::chrono::steady_clock::now() >= deadline;
+		};
+		peers.assign(processCount, -1);
+
+		listenPath = basePath + "." + std::to_string(rank);
+		int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+		if (listener < 0) {
+			return false;
+		}
+		unlink(listenPath.c_str());
+		sockaddr_un address = addressFor(listenPath);
+		if (bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+			listen(listener, static_cast<int>(processCount)) != 0) {
+			close(listener);
+			return false;
+		}
+
+		for (uint32_t peer = 0; peer < rank; peer++) {
+			sockaddr_un peerAddress = addressFor(basePath + "." + std::to_string(peer));
+			int fd = -1;
+			//the peer may not be listening yet
+			while (fd < 0 && !expired()) {
+				fd = socket(AF_UNIX, SOCK_STREAM, 0);
+				if (connect(fd, reinterpret_cast<sockaddr*>(&peerAddress), sizeof(peerAddress)) != 0) {
+					close(fd);
+					fd = -1;
+					std::this_thread::sleep_for(std::chrono::milliseconds(1));
+				}
+			}
+			if (fd < 0 || !writeAll(fd, &rank, sizeof(rank))) {
+				close(listener);
+				return false;
+			}
+			peers[peer] = fd;
+		}
+
+		for (uint32_t accepted = rank + 1; accepted < processCount; accepted++) {
+			//poll in short slices so a rank that never connects can't hold us in accept
+			pollfd waiting{ listener, POLLIN, 0 };
+			int ready = 0;
+			while (ready == 0 && !expired()) {
+				ready = poll(&waiting, 1, 50);
+				if (ready < 0 && errno == EINTR) {
+					ready = 0;
+				}
+			}
+			int fd = ready > 0 ? accept(listener, nullptr, nullptr) : -1;
+			uint32_t peer = 0;
+			if (fd < 0 || !readAll(fd, &peer, sizeof(peer)) || peer >= processCount) {
+				close(listener);
+				return false;
+			}
+			peers[peer] = fd;
+		}
+		close(listener);
+
+		for (int fd : peers) {
+			if (fd >= 0) {
+				fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+			}
+		}
+		return true;
+	}
+
+	uint64_t exchange(uint64_t, const std::vector<std::vector<crossSpike>>& outbound,
+		std::vector<crossSpike>& inbound) override {
+
+		struct peerIO {
+			std::vector<char> out;
+			size_t sent = 0;
+			uint32_t count = 0;
+			std::vector<char> in;
+			size_t received = 0;
+			bool haveCount = false;
+			bool done = false;
+		};
+
+		std::vector<peerIO> io(peers.size());
+		for (uint32_t peer = 0; peer < peers.size(); peer++) {
+			if (peers[peer] < 0) {
+				io[peer].done = true;
+				continue;
+			}
+			uint32_t count = static_cast<uint32_t>(outbound[peer].size());
+			io[peer].out.resize(sizeof(count) + count * sizeof(crossSpike));
+			std::memcpy(io[peer].out.data(), &count, sizeof(count));
+			if (count > 0) {
+				std::memcpy(io[peer].out.data() + sizeof(count), outbound[peer].data(), count * sizeof(crossSpike));
+			}
+			io[peer].in.resize(sizeof(uint32_t));
+		}
+
+		uint64_t stall = 0;
+		while (true) {
+			std::vector<pollfd> waiting;
+			std::vector<uint32_t> waitingPeer;
+			for (uint32_t peer = 0; peer < peers.size(); peer++) {
+				short events = 0;
+				if (peers[peer] >= 0 && io[peer].sent < io[peer].out.size()) {
+					events |= POLLOUT;
+				}
+				if (!io[peer].done) {
+					events |= POLLIN;
+				}
+				if (events != 0) {
+					waiting.push_back({ peers[peer], events, 0 });
+					waitingPeer.push_back(peer);
+				}
+			}
+			if (waiting.empty()) {
+				break;
+			}
+
+			auto waitStart = std::chrono::steady_clock::now();
+			int ready = poll(waiting.data(), waiting.size(), 50);
+			stall += nanosSince(waitStart);
+			if (ready < 0 && errno != EINTR) {
+				broken = true;
+				break;
+			}
+			if (ready <= 0) {
+				if (aborted()) {
+					broken = true;
+					break;
+				}
+				continue;
+			}
+
+			for (size_t i = 0; i < waiting.size(); i++) {
+				peerIO& p = io[waitingPeer[i]];
+				int fd = waiting[i].fd;
+				if (waiting[i].revents & POLLOUT) {
+					ssize_t n = send(fd, p.out.data() + p.sent, p.out.size() - p.sent, MSG_NOSIGNAL);
+					if (n > 0) {
+						p.sent += static_cast<size_t>(n);
+					}
+					else if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+						broken = true;
+					}
+				}
+				if (waiting[i].revents & (POLLIN | POLLHUP | POLLERR)) {
+					ssize_t n = recv(fd, p.in.data() + p.received, p.in.size() - p.received, 0);
+					if (n <= 0) {
+						if (n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK)) {
+							//peer went away mid run, its spikes for this tick will never come
+							p.done = true;
+							broken = true;
+						}
+						continue;
+					}
+					p.received += static_cast<size_t>(n);
+					if (p.received < p.in.size()) {
+						continue;
+					}
+					if (!p.haveCount) {
+						std::memcpy(&p.count, p.in.data(), sizeof(p.count));
+						p.haveCount = true;
+						p.in.resize(p.count * sizeof(crossSpike));
+						p.received = 0;
+						p.done = p.count == 0;
+					}
+					else {
+						size_t start = inbound.size();
+						inbound.resize(start + p.count);
+						std::memcpy(inbound.data() + start, p.in.data(), p.in.size());
+						p.done = true;
+					}
+				}
+			}
+			//a dead peer's socket stays writable-with-error, looping on it would spin forever
+			if (broken) {
+				break;
+			}
+		}
+		return stall;
+	}
+
+private:
+	static sockaddr_un addressFor(const std::string& path) {
+		sockaddr_un address{};
+		address.sun_family = AF_UNIX;
+		std::strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+		return address;
+	}
+
+	static bool writeAll(int fd, const void* data, size_t bytes) {
+		const char* p = static_cast<const char*>(data);
+		while (bytes > 0) {
+			ssize_t n = write(fd, p, bytes);
+			if (n <= 0) {
+				return false;
+			}
+			p += n;
+			bytes -= static_cast<size_t>(n);
+		}
+		return true;
+	}
+
+	static bool readAll(int fd, void* data, size_t bytes) {
+		char* p = static_cast<char*>(data);
+		while (bytes > 0) {
+			ssize_t n = read(fd, p, bytes);
+			if (n <= 0) {
+				return false;
+			}
+			p += n;
+			bytes -= static_cast<size_t>(n);
+		}
+		return true;
+	}
+
+	std::vector<int> peers;
+	std::string listenPath;
+	uint32_t rank = 0;
+};
+
+//order independent fingerprint of neuron state, to compare a partitioned run with a single process one
+uint64_t neuronFingerprint(uint32_t globalRef, const genericNeuronState& n) {
+	uint64_t h = (static_cast<uint64_t>(globalRef) << 32) ^ static_cast<uint32_t>(n.input);
+	h ^= static_cast<uint64_t>(static_cast<int64_t>(n.neuronCharge)) * 0x9E3779B97F4A7C15ull;
+	return h * 0xBF58476D1CE4E5B9ull;
+}
+
+uint64_t neuronFingerprint(uint32_t globalRef, const rewardNeuronState& n) {
+	uint64_t h = (static_cast<uint64_t>(globalRef) << 32) ^ static_cast<uint32_t>(n.input);
+	return (h ^ static_cast<uint64_t>(n.cooldown)) * 0xBF58476D1CE4E5B9ull;
+}
+
+uint64_t brainStateChecksum() {
+	uint64_t sum = 0;
+	brain.forEachBank([&sum](auto& bank) {
+		using policy = typename std::decay_t<decltype(bank)>::policy;
+		bank.pool.forEach([&sum](uint32_t index, typename policy::state& n) {
+			sum += neuronFingerprint(makeNeuronRef(policy::type, index), n);
+		});
+	});
+	return sum;
+}
+
+uint64_t shardStateChecksum(networkShard& shard) {
+	uint64_t sum = 0;
+	for (const auto& pair : shard.globalNeuronRefs) {
+		shard.store.visitNeuron(pair.first, [&](auto& bank, uint32_t index) {
+			sum += neuronFingerprint(pair.second, bank.pool.at(index));
+		});
+	}
+	return sum;
+}
+
+//runs one partition until the coordinator says stop, false when the run was aborted
+bool runPartitionWorker(networkShard& shard, uint32_t rank, partitionControl& control, spikeTransport& transport) {
+
+	std::vector<std::vector<crossSpike>> outbound(control.processCount);
+	std::vector<crossSpike> inbound;
+	std::vector<queuedSpike> batch;
+	partitionStats& stats = control.stats[rank];
+	transport.abortFlag = &control.aborted;
+
+	for (uint64_t tick = 1;; tick++) {
+
+		auto waitStart = std::chrono::steady_clock::now();
+		uint64_t go;
+		while ((go = control.goTick.value.load(std::memory_order_acquire)) < tick) {
+			if (control.aborted.load(std::memory_order_acquire)) {
+				return false;
+			}
+			std::this_thread::yield();
+		}
+		if (go == stopTick) {
+			break;
+		}
+		uint64_t stall = nanosSince(waitStart);
+
+		//every rank starts the tick from the same reward tally, the reward neuron only lives in one
+		int rewardBefore = static_cast<int>(control.rewardTotal.load(std::memory_order_acquire));
+		rewardValue = rewardBefore;
+
+		//spikes that crossed over last tick land this tick, same as the threaded mailboxes
+		batch.clear();
+		for (const crossSpike& spike : inbound) {
+			batch.push_back({ spike.neuronRef, noSynapse, spike.strength });
+		}
+
+		stepShard(shard, batch, [&outbound](uint32_t to, const crossSpike& spike) {
+			outbound[to].push_back(spike);
+		});
+		stats.rewardChange += rewardValue - rewardBefore;
+
+		uint64_t sent = 0;
+		for (const auto& spikes : outbound) {
+			sent += spikes.size();
+		}
+
+		inbound.clear();
+		stall += transport.exchange(tick, outbound, inbound);
+		for (auto& spikes : outbound) {
+			spikes.clear();
+		}
+		if (transport.broken) {
+			control.aborted.store(1, std::memory_order_release);
+			return false;
+		}
+
+		stats.ticks++;
+		stats.spikesSent += sent;
+		stats.spikesReceived += inbound.size();
+		stats.lastTickSpikes = sent + inbound.size();
+		stats.stallNanos += stall;
+		stats.maxTickStallNanos = std::max(stats.maxTickStallNanos, stall);
+
+		control.doneTick[rank].value.store(tick, std::memory_order_release);
+	}
+
+	stats.stateChecksum = shardStateChecksum(shard);
+	return true;
+}
+
+struct partitionWorker {
+	pid_t pid = -1;
+	bool exited = false;
+	int status = 0;
+};
+
+//false once the process is gone, keeps its exit status
+bool workerAlive(partitionWorker& worker) {
+	if (worker.exited) {
+		return false;
+	}
+	if (waitpid(worker.pid, &worker.status, WNOHANG) == worker.pid) {
+		worker.exited = true;
+		return false;
+	}
+	return true;
+}
+
+//the tick barrier, no worker starts tick t + 1 before every worker finished tick t.
+//also sums the ranks' reward changes after each tick. returns false, with the run aborted,
+//when a rank dies, reports a failure or takes longer than tickTimeoutMs on one tick
+bool coordinatePartitions(partitionControl& control, uint64_t ticks, std::vector<partitionWorker>& workers) {
+	int64_t rewardStart = control.rewardTotal.load();
+
+	for (uint64_t tick = 1; tick <= ticks; tick++) {
+		control.goTick.value.store(tick, std::memory_order_release);
+		auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(partitioning.tickTimeoutMs);
+
+		for (uint32_t rank = 0; rank < control.processCount; rank++) {
+			for (uint32_t spins = 0; control.doneTick[rank].value.load(std::memory_order_acquire) < tick; spins++) {
+				//a dead rank stalls its peers rather than this one, so every worker is checked.
+				//syscalls and a clock read every so often, not on every spin
+				if ((spins & 255) == 255 && (control.aborted.load(std::memory_order_acquire) ||
+					!std::all_of(workers.begin(), workers.end(), workerAlive) || std::chrono::steady_clock::now() >= deadline)) {
+					control.aborted.store(1, std::memory_order_release);
+					control.goTick.value.store(stopTick, std::memory_order_release);
+					return false;
+				}
+				std::this_thread::yield();
+			}
+		}
+
+		int64_t total = rewardStart;
+		for (uint32_t rank = 0; rank < control.processCount; rank++) {
+			total += control.stats[rank].rewardChange;
+		}
+		control.rewardTotal.store(total, std::memory_order_release);
+	}
+	control.goTick.value.store(stopTick, std::memory_order_release);
+	return true;
+}
+
+//waits for every worker, killing the ones still running once graceMs is up
+void reapPartitionWorkers(std::vector<partitionWorker>& workers, uint32_t graceMs) {
+	auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(graceMs);
+	bool waiting = true;
+	while (waiting && std::chrono::steady_clock::now() < deadline) {
+		waiting = false;
+		for (partitionWorker& worker : workers) {
+			waiting |= workerAlive(worker);
+		}
+		if (waiting) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+	}
+	for (partitionWorker& worker : workers) {
+		if (!worker.exited) {
+			kill(worker.pid, SIGKILL);
+			waitpid(worker.pid, &worker.status, 0);
+			worker.exited = true;
+		}
+	}
+}
+
+void printPartitionReport(const std::vector<partitionStats>& stats) {
+	for (size_t rank = 0; rank < stats.size(); rank++) {
+		const partitionStats& s = stats[rank];
+		double ticks = s.ticks ? double(s.ticks) : 1.0;
+		std::printf("partition %zu: %.1f spikes/tick exchanged (%.0f bytes), stall %.1f us/tick avg, %.1f us max\n",
+			rank, (s.spikesSent + s.spikesReceived) / ticks,
+			(s.spikesSent + s.spikesReceived) * sizeof(crossSpike) / ticks,
+			s.stallNanos / ticks / 1000.0, s.maxTickStallNanos / 1000.0);
+	}
+}
+
+enum class transportKind { sharedMemory, localSocket };
+
+//splits the current brain into processCount partitions, forks a worker for each and coordinates
+//them from this process. name prefixes the shared memory regions and socket paths.
+//the workers' state never comes back, so the brain, its spikeQueue and rewardValue are left as
+//they were. the outcome is in results (per rank state checksums) and finalReward
+bool runLocalPartitioned(uint32_t processCount, uint64_t ticks, transportKind kind, const std::string& name,
+	std::vector<partitionStats>* results = nullptr, int* finalReward = nullptr) {
+
+	processCount = std::max<uint32_t>(1, std::min(processCount, maxPartitions));
+
+	//build hands the queued spikes to the shards, the brain keeps its own copy
+	std::vector<queuedSpike> queued;
+	{
+		std::lock_guard<std::mutex> lock(spikeQueueMute);
+		queued = spikeQueue;
+	}
+	shardedEngine layout;
+	layout.build(processCount);
+	{
+		std::lock_guard<std::mutex> lock(spikeQueueMute);
+		spikeQueue = std::move(queued);
+	}
+
+	sharedRegion controlRegion;
+	if (!controlRegion.create("/" + name + ".control", sizeof(partitionControl))) {
+		return false;
+	}
+	partitionControl& control = *new (controlRegion.data()) partitionControl();
+	control.processCount = processCount;
+
+	uint32_t capacity = sharedMemoryTransport::defaultCapacity;
+	sharedRegion ringRegion;
+	if (kind == transportKind::sharedMemory) {
+		if (!ringRegion.create("/" + name + ".rings", sharedMemoryTransport::regionBytes(processCount, capacity))) {
+			return false;
+		}
+		sharedMemoryTransport::initialize(ringRegion.data(), processCount, capacity);
+	}
+
+	control.rewardTotal.store(rewardValue.load());
+
+	std::vector<partitionWorker> workers;
+	for (uint32_t rank = 0; rank < processCount; rank++) {
+		pid_t pid = fork();
+		if (pid < 0) {
+			break;
+		}
+		if (pid == 0) {
+			layout.releaseAllBut(rank);
+			bool finished;
+			if (kind == transportKind::sharedMemory) {
+				//the mapping is inherited across fork
+				sharedMemoryTransport transport(ringRegion.data(), processCount, capacity, rank);
+				finished = runPartitionWorker(layout.shard(rank), rank, control, transport);
+			}
+			else {
+				socketTransport transport;
+				transport.abortFlag = &control.aborted;
+				finished = transport.connectPeers("/tmp/" + name, rank, processCount, partitioning.connectTimeoutMs) &&
+					runPartitionWorker(layout.shard(rank), rank, control, transport);
+			}
+			if (!finished) {
+				//don't leave the coordinator or the other ranks waiting on us
+				control.aborted.store(1, std::memory_order_release);
+			}
+			std::_Exit(finished ? 0 : 1);
+		}
+		workers.push_back({ pid });
+	}
+
+	bool ok = workers.size() == processCount && coordinatePartitions(control, ticks, workers);
+	if (!ok) {
+		control.aborted.store(1, std::memory_order_release);
+		control.goTick.value.store(stopTick, std::memory_order_release);
+	}
+
+	reapPartitionWorkers(workers, ok ? partitioning.tickTimeoutMs : partitioning.shutdownGraceMs);
+	for (const partitionWorker& worker : workers) {
+		ok &= WIFEXITED(worker.status) && WEXITSTATUS(worker.status) == 0;
+	}
+	if (ok && finalReward != nullptr) {
+		*finalReward = static_cast<int>(control.rewardTotal.load());
+	}
+
+	std::vector<partitionStats> stats(control.stats, control.stats + processCount);
+	printPartitionReport(stats);
+	if (results != nullptr) {
+		*results = stats;
+	}
+	return ok;
+}
+
+#endif
+
+//-------------------------
+//out of core synapse storage
+//a compiled copy of the network whose synapses live in a memory mapped file instead of the heap.
+//generic neurons are grouped into regions by position (cubes of regionSide cells), and each region's
+//outgoing synapses are one page aligned block in the file: child targets, then strengths, then ages.
+//neuron state and the small tables stay in memory. a firing neuron only touches its own region's
+//block, so only regions in use need to be in RAM. a read-ahead thread madvises blocks in for regions
+//whose neurons are about to fire and pages out the coldest regions when residency goes over budget.
+//the file is the network: changed strengths and ages are written back to it, and open() runs a file
+//built earlier without the brain in memory at all. build() writes from the brain, synapseFileWriter
+//writes from anything that can hand over one region at a time, for networks that never fit in RAM.
+//neuron updates follow the fixed point engine, spikes into other neuron types are dropped.
+//POSIX only
+
+#if !defined(_WIN32)
+
+struct outOfCoreSettings {
+	long regionSide = 16;					//cells per side of a region cube
+	uint32_t maxRegionEdges = 1u << 20;		//bigger cubes are cut into several regions
+	size_t residentBudgetBytes = size_t(1) << 30;	//synapse blocks kept in RAM before cold ones are paged out
+	double heatHalfLife = 64;				//ticks for a region's activity score to halve
+	uint64_t evictInterval = 16;			//ticks between residency checks
+};
+
+struct outOfCoreStats {
+	uint64_t ticks = 0;
+	uint64_t spikes = 0;
+	uint64_t regionTouches = 0;		//distinct regions read per tick, summed
+	uint64_t coldTouches = 0;		//of those, regions not believed to be resident
+	uint64_t prefetchHits = 0;		//touches of a region prefetched ahead of use
+	uint64_t prefetches = 0;
+	uint64_t evictions = 0;			//cold regions paged out, memory handed back to the system
+	uint64_t droppedMappings = 0;	//cold regions only unmapped, see pageOutAdvice
+};
+
+//file layout: a header page, one page aligned block per region, then the neuron table and the
+//region table. the tables go last so a writer can stream blocks out before it knows how many
+//neurons there will be, and the header is written last of all so a half written file never opens
+constexpr uint64_t synapseFileMagic = 0x4E53594E41505345ull;
+constexpr uint32_t synapseFileVersion = 2;
+
+struct synapseFileHeader {
+	uint64_t magic = synapseFileMagic;
+	uint32_t version = synapseFileVersion;
+	uint32_t reserved = 0;
+	uint64_t neuronCount = 0;
+	uint64_t regionCount = 0;
+	uint64_t edgeCount = 0;
+	uint64_t tableOffset = 0;		//neuron table, region table right after it
+	uint64_t fileBytes = 0;
+};
+
+struct synapseFileNeuron {
+	uint32_t sourceRef = 0;		//brain ref when the file was built, or whatever id the writer's caller uses
+	uint32_t region = 0;
+	int64_t x = 0, y = 0, z = 0;
+	uint64_t edgeBegin = 0;		//first outgoing synapse, counted across the whole file
+	uint32_t edgeCount = 0;
+	int16_t threshold = 0;		//fire threshold already adjusted for fan in
+	int16_t reserved = 0;
+};
+
+struct synapseFileRegion {
+	uint64_t offset = 0;		//page aligned block: targets, strengths, ages
+	uint64_t edgeBegin = 0;
+	uint64_t edgeCount = 0;
+	uint32_t firstNeuron = 0;
+	uint32_t neuronCount = 0;
+};
+
+size_t pageSize() {
+	static const size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+	return page;
+}
+
+uint64_t alignToPage(uint64_t bytes) {
+	uint64_t page = pageSize();
+	return (bytes + page - 1) / page * page;
+}
+
+uint64_t synapseBlockBytes(uint64_t edges) {
+	return edges * (sizeof(uint32_t) + sizeof(int16_t) + sizeof(uint8_t));
+}
+
+bool writeAt(int fd, uint64_t offset, const void* data, size_t bytes) {
+	const char* p = static_cast<const char*>(data);
+	while (bytes > 0) {
+		ssize_t wrote = pwrite(fd, p, bytes, static_cast<off_t>(offset));
+		if (wrote < 0 && errno == EINTR) {
+			continue;
+		}
+		if (wrote <= 0) {
+			return false;
+		}
+		p += wrote;
+		offset += static_cast<uint64_t>(wrote);
+		bytes -= static_cast<size_t>(wrote);
+	}
+	return true;
+}
+
+bool readAt(int fd, uint64_t offset, void* data, size_t bytes) {
+	char* p = static_cast<char*>(data);
+	while (bytes > 0) {
+		ssize_t got = pread(fd, p, bytes, static_cast<off_t>(offset));
+		if (got < 0 && errno == EINTR) {
+			continue;
+		}
+		if (got <= 0) {
+			return false;
+		}
+		p += got;
+		offset += static_cast<uint64_t>(got);
+		bytes -= static_cast<size_t>(got);
+	}
+	return true;
+}
+
+//writes a synapse file one region at a time. only the neuron and region tables are held until
+//finish, the synapses never more than the region being appended, so the network doesn't have to
+//exist in memory anywhere. targets are file indices, a neuron's place counting across every region
+//in append order, so the caller has to know that order up front. finish checks them
+class synapseFileWriter {
+public:
+
+	~synapseFileWriter() {
+		if (fd >= 0) {
+			::close(fd);
+		}
+	}
+
+	bool create(const std::string& path) {
+		if (fd >= 0) {
+			::close(fd);
+		}
+		neurons.clear();
+		regions.clear();
+		edgeTotal = 0;
+		targetLimit = 0;
+		failed = false;
+		fd = ::open(path.c_str(), O_CREAT | O_TRUNC | O_RDWR, 0600);
+		if (fd < 0) {
+			std::printf("out of core: can't create %s (%s)\n", path.c_str(), std::strerror(errno));
+			return false;
+		}
+		offset = alignToPage(sizeof(synapseFileHeader));
+		return true;
+	}
+
+	//regionNeurons in file order with sourceRef, position, threshold and edgeCount filled in, region
+	//and edgeBegin are set here. each neuron's edges follow the last one's in targets, strengths and
+	//ages, so all three hold the sum of edgeCount
+	bool appendRegion(const std::vector<synapseFileNeuron>& regionNeurons, const std::vector<uint32_t>& targets,
+		const std::vector<int16_t>& strengths, const std::vector<uint8_t>& ages) {
+		if (fd < 0 || failed) {
+			return false;
+		}
+		if (regionNeurons.empty()) {
+			return true;
+		}
+		uint64_t edges = 0;
+		for (const synapseFileNeuron& n : regionNeurons) {
+			edges += n.edgeCount;
+		}
+		if (edges != targets.size() || edges != strengths.size() || edges != ages.size() ||
+			neurons.size() + regionNeurons.size() > std::numeric_limits<uint32_t>::max()) {
+			std::printf("out of core: region %zu doesn't add up, %llu edges for %zu targets\n", regions.size(),
+				static_cast<unsigned long long>(edges), targets.size());
+			failed = true;
+			return false;
+		}
+
+		synapseFileRegion region;
+		region.offset = offset;
+		region.edgeBegin = edgeTotal;
+		region.edgeCount = edges;
+		region.firstNeuron = static_cast<uint32_t>(neurons.size());
+		region.neuronCount = static_cast<uint32_t>(regionNeurons.size());
+
+		uint64_t edgeBegin = edgeTotal;
+		for (const synapseFileNeuron& n : regionNeurons) {
+			neurons.push_back(n);
+			neurons.back().region = static_cast<uint32_t>(regions.size());
+			neurons.back().edgeBegin = edgeBegin;
+			edgeBegin += n.edgeCount;
+		}
+		for (uint32_t target : targets) {
+			targetLimit = std::max<uint64_t>(targetLimit, uint64_t(target) + 1);
+		}
+
+		failed = !writeAt(fd, offset, targets.data(), targets.size() * sizeof(uint32_t)) ||
+			!writeAt(fd, offset + edges * sizeof(uint32_t), strengths.data(), strengths.size() * sizeof(int16_t)) ||
+			!writeAt(fd, offset + edges * (sizeof(uint32_t) + sizeof(int16_t)), ages.data(), ages.size());
+		regions.push_back(region);
+		edgeTotal += edges;
+		offset += alignToPage(synapseBlockBytes(edges));
+		return !failed;
+	}
+
+	//writes the tables, then the header. fails, leaving a file open() rejects, if a write failed or
+	//a target points past the last neuron appended
+	bool finish() {
+		if (fd < 0) {
+			return false;
+		}
+		bool ok = !failed;
+		if (ok && targetLimit > neurons.size()) {
+			std::printf("out of core: a synapse targets neuron %llu, only %zu were written\n",
+				static_cast<unsigned long long>(targetLimit - 1), neurons.size());
+			ok = false;
+		}
+
+		synapseFileHeader header;
+		header.neuronCount = neurons.size();
+		header.regionCount = regions.size();
+		header.edgeCount = edgeTotal;
+		header.tableOffset = offset;
+		header.fileBytes = offset + neurons.size() * sizeof(synapseFileNeuron) + regions.size() * sizeof(synapseFileRegion);
+
+		ok = ok && writeAt(fd, offset, neurons.data(), neurons.size() * sizeof(synapseFileNeuron)) &&
+			writeAt(fd, offset + neurons.size() * sizeof(synapseFileNeuron), regions.data(), regions.size() * sizeof(synapseFileRegion)) &&
+			fsync(fd) == 0 && writeAt(fd, 0, &header, sizeof(header));
+		if (!ok) {
+			std::printf("out of core: writing the synapse file failed\n");
+		}
+		::close(fd);
+		fd = -1;
+		neurons = std::vector<synapseFileNeuron>();
+		regions = std::vector<synapseFileRegion>();
+		return ok;
+	}
+
+	size_t neuronCount() const { return neurons.size(); }
+
+private:
+	int fd = -1;
+	uint64_t offset = 0;			//where the next block goes
+	uint64_t edgeTotal = 0;
+	uint64_t targetLimit = 0;		//highest target seen plus one
+	bool failed = false;
+	std::vector<synapseFileNeuron> neurons;
+	std::vector<synapseFileRegion> regions;
+};
+
+class outOfCoreEngine {
+public:
+	outOfCoreSettings settings;
+
+	~outOfCoreEngine() {
+		close();
+	}
+
+	//writes the brain's generic neurons and their synapses to path and maps it. the file goes out
+	//through synapseFileWriter one region at a time, so beyond the brain itself only one region's
+	//synapses are held in memory
+	bool build(const std::string& path) {
+		close();
+
+		std::shared_lock<std::shared_mutex> neuronLock(neuronMapMutex);
+		std::shared_lock<std::shared_mutex> synapseLock(synapseMapMutex);
+		epochGuard guard;
+
+		std::vector<synapseFileNeuron> table;
+		std::unordered_map<uint32_t, uint32_t> denseOf;
+		brain.genericBank.pool.forEach([&](uint32_t index, genericNeuronState& n) {
+			synapseFileNeuron record;
+			record.sourceRef = makeNeuronRef(NeuronType::generic, index);
+			record.x = n.positionData.Position.x;
+			record.y = n.positionData.Position.y;
+			record.z = n.positionData.Position.z;
+			record.threshold = saturate16(adjustThreshold(n.fireThreshold, n.fanIn.load()));
+			table.push_back(record);
+		});
+
+		//region order: cube by cube, then position inside the cube
+		long side = std::max(1L, settings.regionSide);
+		auto cubeOf = [side](const synapseFileNeuron& n) {
+			auto cell = [side](long v) { return v >= 0 ? v / side : -((-v + side - 1) / side); };
+			return cellPosition{ cell(n.x), cell(n.y), cell(n.z) };
+		};
+		std::sort(table.begin(), table.end(), [&cubeOf](const synapseFileNeuron& a, const synapseFileNeuron& b) {
+			cellPosition ca = cubeOf(a);
+			cellPosition cb = cubeOf(b);
+			if (ca < cb || cb < ca) {
+				return ca < cb;
+			}
+			return cellPosition{ a.x, a.y, a.z } < cellPosition{ b.x, b.y, b.z };
+		});
+		for (uint32_t i = 0; i < table.size(); i++) {
+			denseOf[table[i].sourceRef] = i;
+		}
+
+		auto keptEdges = [&](uint32_t i, std::vector<uint32_t>* targets, std::vector<int16_t>* strengths, std::vector<uint8_t>* ages) {
+			const genericNeuronState& n = brain.genericBank.pool.at(neuronRefIndex(table[i].sourceRef));
+			uint32_t count = 0;
+			for (uint32_t synapseIndex : n.childSynapses.read()) {
+				const Synapse& syn = brain.synapsePool.at(synapseIndex);
+				auto target = denseOf.find(syn.childNeuron);
+				if (target == denseOf.end()) {
+					continue;
+				}
+				if (targets != nullptr) {
+					targets->push_back(target->second);
+					strengths->push_back(syn.strength);
+					ages->push_back(syn.age);
+				}
+				count++;
+			}
+			return count;
+		};
+
+		synapseFileWriter writer;
+		if (!writer.create(path)) {
+			return false;
+		}
+
+		//cut regions at cube boundaries, and inside a cube once it reaches maxRegionEdges
+		std::vector<synapseFileNeuron> regionNeurons;
+		std::vector<uint32_t> targets;
+		std::vector<int16_t> strengths;
+		std::vector<uint8_t> ages;
+		bool ok = true;
+		for (uint32_t i = 0; ok && i < table.size(); i++) {
+			uint32_t edges = keptEdges(i, nullptr, nullptr, nullptr);
+			bool newCube = i > 0 && [&]() {
+				cellPosition a = cubeOf(table[i - 1]);
+				cellPosition b = cubeOf(table[i]);
+				return a < b || b < a;
+			}();
+			if (!regionNeurons.empty() && (newCube || targets.size() + edges > settings.maxRegionEdges)) {
+				ok = writer.appendRegion(regionNeurons, targets, strengths, ages);
+				regionNeurons.clear();
+				targets.clear();
+				strengths.clear();
+				ages.clear();
+			}
+			table[i].edgeCount = keptEdges(i, &targets, &strengths, &ages);
+			regionNeurons.push_back(table[i]);
+		}
+		ok = ok && writer.appendRegion(regionNeurons, targets, strengths, ages);
+		if (!writer.finish() || !ok) {
+			return false;
+		}
+		if (!open(path)) {
+			return false;
+		}
+
+		//start from the brain's state, including spikes already queued for next tick
+		std::lock_guard<std::mutex> queueLock(spikeQueueMute);
+		for (uint32_t i = 0; i < neurons.size(); i++) {
+			const genericNeuronState& n = brain.genericBank.pool.at(neuronRefIndex(neurons[i].sourceRef));
+			input[i] = saturate16(n.input);
+			charge[i] = saturate16(static_cast<int>(n.neuronCharge));
+			exhaustion[i] = static_cast<uint8_t>(std::min(255, n.exhaustionLevel));
+			canFire[i] = n.canFire ? 1 : 0;
+		}
+		for (const queuedSpike& spike : spikeQueue) {
+			auto target = denseOf.find(spike.childNeuron);
+			if (target != denseOf.end()) {
+				incoming[target->second] = saturate16(incoming[target->second] + fixedInput(spike.strength));
+			}
+		}
+		return true;
+	}
+
+	//maps a file written by build or synapseFileWriter, neurons start at rest. the layout is checked
+	//before anything is sized or mapped from it, including every synapse target, so opening reads
+	//the whole file once
+	bool open(const std::string& path) {
+		close();
+
+		int fd = ::open(path.c_str(), O_RDWR);
+		if (fd < 0) {
+			std::printf("out of core: can't open %s (%s)\n", path.c_str(), std::strerror(errno));
+			return false;
+		}
+		synapseFileHeader header;
+		struct stat info;
+		bool ok = readAt(fd, 0, &header, sizeof(header)) && header.magic == synapseFileMagic &&
+			header.version == synapseFileVersion && fstat(fd, &info) == 0 &&
+			static_cast<uint64_t>(info.st_size) >= header.fileBytes &&
+			//the tables have to fit between tableOffset and the end before they are read
+			header.neuronCount <= std::numeric_limits<uint32_t>::max() && header.regionCount <= header.neuronCount &&
+			header.tableOffset >= alignToPage(sizeof(header)) && header.tableOffset <= header.fileBytes &&
+			header.fileBytes - header.tableOffset >=
+				header.neuronCount * sizeof(synapseFileNeuron) + header.regionCount * sizeof(synapseFileRegion);
+		if (ok) {
+			neurons.resize(header.neuronCount);
+			regions.resize(header.regionCount);
+			ok = readAt(fd, header.tableOffset, neurons.data(), neurons.size() * sizeof(synapseFileNeuron)) &&
+				readAt(fd, header.tableOffset + neurons.size() * sizeof(synapseFileNeuron), regions.data(),
+					regions.size() * sizeof(synapseFileRegion)) &&
+				layoutValid(fd, header);
+			//the check read every block, hand the clean pages back so regions only come in when used
+			posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+		}
+		if (ok) {
+			void* mapped = mmap(nullptr, header.fileBytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+			ok = mapped != MAP_FAILED;
+			if (ok) {
+				base = static_cast<uint8_t*>(mapped);
+				mappedBytes = header.fileBytes;
+				//fault in only what is asked for, the read-ahead thread does the prefetching
+				madvise(base, mappedBytes, MADV_RANDOM);
+			}
+		}
+		::close(fd);
+		if (!ok) {
+			std::printf("out of core: %s is not a synapse file this build can read\n", path.c_str());
+			neurons.clear();
+			regions.clear();
+			return false;
+		}
+
+		size_t count = neurons.size();
+		input.assign(count, 0);
+		incoming.assign(count, 0);
+		charge.assign(count, -65);
+		exhaustion.assign(count, 0);
+		canFire.assign(count, 1);
+		firedList.clear();
+
+		heat.assign(regions.size(), 0);
+		lastTouched.assign(regions.size(), 0);
+		touchedTick.assign(regions.size(), 0);
+		queuedTick.assign(regions.size(), 0);
+		resident.assign(regions.size(), 0);
+		residentBytes = 0;
+		stats = outOfCoreStats();
+		now = 0;
+
+		stopping = false;
+		readAhead = std::thread([this]() { readAheadLoop(); });
+		return true;
+	}
+
+	void close() {
+		{
+			std::lock_guard<std::mutex> lock(readAheadMute);
+			stopping = true;
+		}
+		readAheadWake.notify_all();
+		if (readAhead.joinable()) {
+			readAhead.join();
+		}
+		readAheadQueue.clear();
+		if (base != nullptr) {
+			msync(base, mappedBytes, MS_SYNC);
+			munmap(base, mappedBytes);
+			base = nullptr;
+			mappedBytes = 0;
+		}
+	}
+
+	//stimulus for next tick, index is the neuron's place in the file
+	void injectInput(uint32_t neuron, int amount) {
+		if (neuron < incoming.size()) {
+			incoming[neuron] = saturate16(incoming[neuron] + amount);
+		}
+	}
+
+	//firedNeurons collects the brain refs the file was built from
+	void tick(std::vector<uint32_t>* firedNeurons = nullptr) {
+		now++;
+		size_t count = neurons.size();
+
+		for (size_t i = 0; i < count; i++) {
+			input[i] = saturate16(input[i] + incoming[i]);
+			incoming[i] = 0;
+		}
+
+		//same steps as fixedPointEngine::tick
+		firedList.clear();
+		for (size_t i = 0; i < count; i++) {
+			int in = input[i];
+			int c = charge[i];
+			int e = exhaustion[i];
+
+			bool fire = (c + in > neurons[i].threshold) & (canFire[i] != 0);
+			input[i] = static_cast<int16_t>(in > 95 ? in - 95 : 0);
+
+			int firedCharge = c == -65 ? -80 : -(80 + e);
+			int firedExhaustion = c == -65 ? 1 : e + 1;
+			int restingCharge = c < -67 ? c + 2 : (c > -63 ? c - 2 : -65);
+
+			charge[i] = static_cast<int16_t>(fire ? firedCharge : restingCharge);
+			exhaustion[i] = static_cast<uint8_t>(std::min(255, fire ? firedExhaustion : (restingCharge == -65 ? 0 : e)));
+			canFire[i] = static_cast<uint8_t>(fire ? (firedCharge >= -90) : (restingCharge == -65 ? 1 : canFire[i]));
+			if (fire) {
+				firedList.push_back(static_cast<uint32_t>(i));
+			}
+		}
+
+		std::vector<uint32_t> prefetch;
+		for (uint32_t i : firedList) {
+			const synapseFileNeuron& n = neurons[i];
+			if (firedNeurons != nullptr) {
+				firedNeurons->push_back(n.sourceRef);
+			}
+			touchRegion(n.region);
+
+			const synapseFileRegion& region = regions[n.region];
+			uint64_t local = n.edgeBegin - region.edgeBegin;
+			const uint32_t* targets = regionTargets(region) + local;
+			const int16_t* strengths = regionStrengths(region) + local;
+
+			for (uint32_t edge = 0; edge < n.edgeCount; edge++) {
+				uint32_t target = targets[edge];
+				incoming[target] = saturate16(incoming[target] + fixedInput(strengths[edge]));
+
+				//likely to fire next tick, get its synapses on the way in now
+				uint32_t targetRegion = neurons[target].region;
+				if (queuedTick[targetRegion] != now && canFire[target] &&
+					charge[target] + input[target] + incoming[target] > neurons[target].threshold) {
+					queuedTick[targetRegion] = now;
+					if (resident[targetRegion] == 0) {
+						resident[targetRegion] = 2;
+						residentBytes += alignToPage(synapseBlockBytes(regions[targetRegion].edgeCount));
+						prefetch.push_back(targetRegion);
+						stats.prefetches++;
+					}
+				}
+			}
+			stats.spikes += n.edgeCount;
+		}
+
+		std::vector<uint32_t> evict;
+		if (settings.evictInterval > 0 && now % settings.evictInterval == 0) {
+			pickEvictions(evict);
+		}
+		if (!prefetch.empty() || !evict.empty()) {
+			std::lock_guard<std::mutex> lock(readAheadMute);
+			for (uint32_t r : evict) {
+				readAheadQueue.push_back({ r, false });
+			}
+			for (uint32_t r : prefetch) {
+				readAheadQueue.push_back({ r, true });
+			}
+		}
+		if (!prefetch.empty() || !evict.empty()) {
+			readAheadWake.notify_one();
+		}
+		stats.ticks++;
+	}
+
+	//updateSynapseStrengths over the file, a region at a time so a full pass streams through it
+	//instead of pulling the whole network into RAM at once
+	void updateStrengths(const bool& reward, const int& amount) {
+		for (size_t r = 0; r < regions.size(); r++) {
+			const synapseFileRegion& region = regions[r];
+			if (r + 1 < regions.size()) {
+				adviseRegion(static_cast<uint32_t>(r + 1), MADV_WILLNEED);
+			}
+			int16_t* strengths = regionStrengths(region);
+			uint8_t* ages = regionAges(region);
+			for (uint64_t e = 0; e < region.edgeCount; e++) {
+				Synapse s;
+				s.strength = strengths[e];
+				s.age = ages[e];
+				s.rewardSynapse(reward, amount);
+				strengths[e] = s.strength;
+				ages[e] = s.age;
+			}
+			//regions the tick isn't using go straight back out
+			if (resident[r] == 0) {
+				adviseRegion(static_cast<uint32_t>(r), pageOutAdvice);
+			}
+		}
+	}
+
+	void flush() {
+		if (base != nullptr) {
+			msync(base, mappedBytes, MS_SYNC);
+		}
+	}
+
+	//pages of the synapse blocks actually in RAM right now, asks the kernel
+	size_t measureResidentBytes() const {
+		if (base == nullptr) {
+			return 0;
+		}
+		size_t page = pageSize();
+		size_t pages = (mappedBytes + page - 1) / page;
+		std::vector<unsigned char> map(pages);
+		if (mincore(base, mappedBytes, map.data()) != 0) {
+			return 0;
+		}
+		size_t in = 0;
+		for (unsigned char m : map) {
+			in += m & 1;
+		}
+		return in * page;
+	}
+
+	outOfCoreStats statistics() const { return stats; }
+	size_t neuronCount() const { return neurons.size(); }
+	size_t regionCount() const { return regions.size(); }
+	uint32_t sourceRef(uint32_t neuron) const { return neurons[neuron].sourceRef; }
+	uint64_t synapseCount() const { return neurons.empty() ? 0 : neurons.back().edgeBegin + neurons.back().edgeCount; }
+	size_t fileBytes() const { return mappedBytes; }
+
+	//what stays in memory whatever the network size
+	size_t bytesPerNeuron() const {
+		//table record plus input, incoming, charge, exhaustion, canFire
+		return sizeof(synapseFileNeuron) + 3 * sizeof(int16_t) + 2;
+	}
+
+private:
+
+	//MADV_PAGEOUT reclaims the pages. without it MADV_DONTNEED only drops them from this mapping,
+	//on a shared file mapping they stay in the page cache until the kernel wants the memory. those
+	//count as droppedMappings rather than evictions, residentBytes still goes down since it tracks
+	//what this process has mapped
+#if defined(MADV_PAGEOUT)
+	static constexpr int pageOutAdvice = MADV_PAGEOUT;
+	static constexpr bool pageOutReclaims = true;
+#else
+	static constexpr int pageOutAdvice = MADV_DONTNEED;
+	static constexpr bool pageOutReclaims = false;
+#endif
+
+	struct readAheadJob {
+		uint32_t region;
+		bool load;		//false pages it out
+	};
+
+	//regions tile the neuron and edge ranges in order and their blocks sit between the header page
+	//and the tables, every neuron's edges are inside its region, every target is a neuron
+	bool layoutValid(int fd, const synapseFileHeader& header) const {
+		uint64_t nextNeuron = 0;
+		uint64_t nextEdge = 0;
+		uint64_t blockStart = alignToPage(sizeof(header));
+		for (const synapseFileRegion& r : regions) {
+			if (r.firstNeuron != nextNeuron || r.neuronCount == 0 || r.edgeBegin != nextEdge ||
+				r.edgeCount > header.fileBytes || r.offset < blockStart || r.offset % pageSize() != 0 ||
+				r.offset + alignToPage(synapseBlockBytes(r.edgeCount)) > header.tableOffset) {
+				return false;
+			}
+			nextNeuron += r.neuronCount;
+			nextEdge += r.edgeCount;
+			blockStart = r.offset + alignToPage(synapseBlockBytes(r.edgeCount));
+		}
+		if (nextNeuron != header.neuronCount || nextEdge != header.edgeCount) {
+			return false;
+		}
+
+		for (uint64_t i = 0; i < neurons.size(); i++) {
+			const synapseFileNeuron& n = neurons[i];
+			if (n.region >= regions.size()) {
+				return false;
+			}
+			const synapseFileRegion& r = regions[n.region];
+			if (i < r.firstNeuron || i >= uint64_t(r.firstNeuron) + r.neuronCount ||
+				n.edgeBegin < r.edgeBegin || n.edgeBegin + n.edgeCount > r.edgeBegin + r.edgeCount) {
+				return false;
+			}
+		}
+
+		//read with pread rather than through the mapping, open drops the pages again afterwards
+		std::vector<uint32_t> chunk(1 << 16);
+		for (const synapseFileRegion& r : regions) {
+			for (uint64_t done = 0; done < r.edgeCount;) {
+				size_t count = static_cast<size_t>(std::min<uint64_t>(chunk.size(), r.edgeCount - done));
+				if (!readAt(fd, r.offset + done * sizeof(uint32_t), chunk.data(), count * sizeof(uint32_t))) {
+					return false;
+				}
+				for (size_t k = 0; k < count; k++) {
+					if (chunk[k] >= header.neuronCount) {
+						return false;
+					}
+				}
+				done += count;
+			}
+		}
+		return true;
+	}
+
+	uint32_t* regionTargets(const synapseFileRegion& r) const {
+		return reinterpret_cast<uint32_t*>(base + r.offset);
+	}
+
+	int16_t* regionStrengths(const synapseFileRegion& r) const {
+		return reinterpret_cast<int16_t*>(base + r.offset + r.edgeCount * sizeof(uint32_t));
+	}
+
+	uint8_t* regionAges(const synapseFileRegion& r) const {
+		return base + r.offset + r.edgeCount * (sizeof(uint32_t) + sizeof(int16_t));
+	}
+
+	void adviseRegion(uint32_t r, int advice) const {
+		const synapseFileRegion& region = regions[r];
+		if (region.edgeCount > 0) {
+			madvise(base + region.offset, alignToPage(synapseBlockBytes(region.edgeCount)), advice);
+		}
+	}
+
+	double decayedHeat(uint32_t r) const {
+		return heat[r] * std::exp2(-static_cast<double>(now - lastTouched[r]) / settings.heatHalfLife);
+	}
+
+	void touchRegion(uint32_t r) {
+		if (touchedTick[r] == now) {
+			return;
+		}
+		touchedTick[r] = now;
+		heat[r] = decayedHeat(r) + 1;
+		lastTouched[r] = now;
+		stats.regionTouches++;
+
+		uint8_t state = resident[r];
+		resident[r] = 1;
+		if (state == 0) {
+			//reading it faults it in
+			stats.coldTouches++;
+			residentBytes += alignToPage(synapseBlockBytes(regions[r].edgeCount));
+		}
+		else if (state == 2) {
+			stats.prefetchHits++;
+		}
+	}
+
+	//coldest resident regions first until back under 90% of the budget
+	void pickEvictions(std::vector<uint32_t>& evict) {
+		if (residentBytes <= settings.residentBudgetBytes) {
+			return;
+		}
+		std::vector<std::pair<double, uint32_t>> candidates;
+		for (uint32_t r = 0; r < regions.size(); r++) {
+			if (resident[r] != 0 && touchedTick[r] != now && queuedTick[r] != now) {
+				candidates.push_back({ decayedHeat(r), r });
+			}
+		}
+		std::sort(candidates.begin(), candidates.end());
+		size_t target = settings.residentBudgetBytes / 10 * 9;
+		for (const auto& c : candidates) {
+			if (residentBytes <= target) {
+				break;
+			}
+			resident[c.second] = 0;
+			residentBytes -= alignToPage(synapseBlockBytes(regions[c.second].edgeCount));
+			evict.push_back(c.second);
+			if (pageOutReclaims) {
+				stats.evictions++;
+			}
+			else {
+				stats.droppedMappings++;
+			}
+		}
+	}
+
+	void readAheadLoop() {
+		std::vector<readAheadJob> jobs;
+		while (true) {
+			{
+				std::unique_lock<std::mutex> lock(readAheadMute);
+				readAheadWake.wait(lock, [this]() { return stopping || !readAheadQueue.empty(); });
+				if (stopping) {
+					return;
+				}
+				jobs.assign(readAheadQueue.begin(), readAheadQueue.end());
+				readAheadQueue.clear();
+			}
+			for (const readAheadJob& job : jobs) {
+				if (job.load) {
+					adviseRegion(job.region, MADV_WILLNEED);
+				}
+				else {
+					adviseRegion(job.region, pageOutAdvice);
+				}
+			}
+		}
+	}
+
+	std::vector<synapseFileNeuron> neurons;
+	std::vector<synapseFileRegion> regions;
+	uint8_t* base = nullptr;
+	size_t mappedBytes = 0;
+
+	std::vector<int16_t> input;
+	std::vector<int16_t> incoming;
+	std::vector<int16_t> charge;
+	std::vector<uint8_t> exhaustion;
+	std::vector<uint8_t> canFire;
+	std::vector<uint32_t> firedList;
+
+	//region residency, only the tick thread reads or changes these
+	uint64_t now = 0;
+	std::vector<double> heat;
+	std::vector<uint64_t> lastTouched;
+	std::vector<uint64_t> touchedTick;
+	std::vector<uint64_t> queuedTick;
+	std::vector<uint8_t> resident;	//0 out, 1 in, 2 prefetched and not used yet
+	size_t residentBytes = 0;
+	outOfCoreStats stats;
+
+	std::mutex readAheadMute;
+	std::condition_variable readAheadWake;
+	std::deque<readAheadJob> readAheadQueue;
+	bool stopping = false;
+	std::thread readAhead;
+};
+
+void printOutOfCoreReport(const outOfCoreEngine& engine) {
+	outOfCoreStats s = engine.statistics();
+	double touches = s.regionTouches ? double(s.regionTouches) : 1.0;
+	std::printf("out of core: %zu neurons, %llu synapses in %zu regions, %zu byte file, %zu resident\n",
+		engine.neuronCount(), static_cast<unsigned long long>(engine.synapseCount()), engine.regionCount(),
+		engine.fileBytes(), engine.measureResidentBytes());
+	std::printf("  %llu ticks, %llu spikes, %.1f regions per tick, %.1f%% cold, %.1f%% prefetched, %llu evictions",
+		static_cast<unsigned long long>(s.ticks), static_cast<unsigned long long>(s.spikes),
+		s.ticks ? double(s.regionTouches) / s.ticks : 0.0, 100.0 * s.coldTouches / touches,
+		100.0 * s.prefetchHits / touches, static_cast<unsigned long long>(s.evictions));
+	if (s.droppedMappings > 0) {
+		std::printf(", %llu unmapped but left in the page cache", static_cast<unsigned long long>(s.droppedMappings));
+	}
+	std::printf("\n");
+}
+
+#endif
+
+//-------------------------
+//self checks
+//a fixed test network and checks for the engines that claim to reproduce the single process
+//engine. build with -DNETWORK_SELF_CHECK for a main that runs them by name
+
+//width x height generic neurons in the z = 0 plane, each with about fanOut short range synapses,
+//plus a reward neuron fed from the first column so reward tallies move too.
+//same network for the same arguments and globalSeed
+void buildCheckNetwork(long width, long height, int fanOut) {
+	randomStream rng{ streamIdFromHash("checkNetwork"), 0 };
+
+	for (long x = 0; x < width; x++) {
+		for (long y = 0; y < height; y++) {
+			createNeuron({ x, y, 0 }, NeuronType::generic);
+		}
+	}
+	cellPosition rewardPos{ -1, 0, 0 };
+	createNeuron(rewardPos, NeuronType::reward);
+
+	long count = width * height * fanOut;
+	for (long i = 0; i < count; i++) {
+		cellPosition a{ getRandom(0, static_cast<int>(width - 1), rng), getRandom(0, static_cast<int>(height - 1), rng), 0 };
+		cellPosition b{ std::min(width - 1, std::max(0L, a.x + getRandom(-3, 3, rng))), getRandom(0, static_cast<int>(height - 1), rng), 0 };
+		createSynapse(a, computeNeuronPositionHash(a), b, computeNeuronPositionHash(b));
+	}
+	for (long y = 0; y < height; y++) {
+		cellPosition a{ 0, y, 0 };
+		createSynapse(a, computeNeuronPositionHash(a), rewardPos, computeNeuronPositionHash(rewardPos));
+	}
+
+	brain.synapsePool.forEach([&rng](uint32_t, Synapse& syn) {
+		//mostly weak, so activity stays bounded and one off input errors would change spike trains
+		syn.strength = static_cast<int16_t>(getRandom(-50, 60, rng));
+	});
+	brain.genericBank.pool.forEach([](uint32_t index, genericNeuronState& n) {
+		if (index % 17 == 0) {
+			n.input = 300;
+		}
+	});
+}
+
+//hands the check network back and forth between the sharded and the single process engine,
+//shardCount shards for ticks, sync, single for ticks, sharded again for ticks, sync, and compares
+//with the single process engine running all of it. in flight spikes have to survive each handover
+bool checkShardedHandover(size_t shardCount, uint64_t ticks) {
+	bool wasDeterministic = deterministicMode;
+	deterministicMode = true;
+
+	releaseNetwork();
+	rewardValue = 0;
+	buildCheckNetwork(80, 10, 5);
+	for (uint64_t t = 0; t < 3 * ticks; t++) {
+		tick();
+	}
+	uint64_t expected = brainStateChecksum();
+	int expectedReward = rewardValue;
+
+	releaseNetwork();
+	rewardValue = 0;
+	buildCheckNetwork(80, 10, 5);
+	shardedEngine engine;
+	engine.build(shardCount);
+	engine.run(ticks);
+	engine.syncToBrain();
+	size_t handedBack;
+	{
+		std::lock_guard<std::mutex> lock(spikeQueueMute);
+		handedBack = spikeQueue.size();
+	}
+	for (uint64_t t = 0; t < ticks; t++) {
+		tick();
+	}
+	engine.run(ticks);
+	engine.syncToBrain();
+	uint64_t got = brainStateChecksum();
+
+	bool ok = got == expected && rewardValue == expectedReward && handedBack > 0;
+	std::printf("sharded %zu ways, %llu ticks, single %llu, sharded %llu: %s (%zu spikes handed back, reward %d, expected %d)\n",
+		shardCount, static_cast<unsigned long long>(ticks), static_cast<unsigned long long>(ticks),
+		static_cast<unsigned long long>(ticks), ok ? "matches" : "MISMATCH", handedBack, rewardValue.load(), expectedReward);
+
+	releaseNetwork();
+	rewardValue = 0;
+	deterministicMode = wasDeterministic;
+	return ok;
+}
+
+//drives the low x end of the check network hard, so shards cut by neuron count do uneven work.
+//checks that a rebuild cut on measured work evens it out, that run() rebalances on its own
+//once it has measured enough ticks, and that the spike trains still match the single engine
+bool checkShardedRebalance(size_t shardCount, uint64_t ticks) {
+	bool wasDeterministic = deterministicMode;
+	deterministicMode = true;
+
+	auto buildSkewed = []() {
+		buildCheckNetwork(80, 10, 5);
+		randomStream rng{ streamIdFromHash("checkRebalance"), 0 };
+		for (long i = 0; i < 600; i++) {
+			cellPosition a{ getRandom(0, 9, rng), getRandom(0, 9, rng), 0 };
+			cellPosition b{ getRandom(0, 9, rng), getRandom(0, 9, rng), 0 };
+			createSynapse(a, computeNeuronPositionHash(a), b, computeNeuronPositionHash(b));
+		}
+		brain.genericBank.pool.forEach([](uint32_t, genericNeuronState& n) {
+			if (n.positionData.Position.x < 10) {
+				n.input = 300;
+			}
+		});
+	};
+	auto imbalance = [](shardedEngine& engine) {
+		uint64_t total = 0;
+		uint64_t busiest = 0;
+		for (size_t i = 0; i < engine.shardCount(); i++) {
+			total += engine.shard(i).work;
+			busiest = std::max(busiest, engine.shard(i).work);
+		}
+		return total == 0 ? 0.0 : double(busiest) * engine.shardCount() / total;
+	};
+
+	releaseNetwork();
+	rewardValue = 0;
+	buildSkewed();
+	for (uint64_t t = 0; t < 4 * ticks; t++) {
+		tick();
+	}
+	uint64_t expected = brainStateChecksum();
+	int expectedReward = rewardValue;
+
+	releaseNetwork();
+	rewardValue = 0;
+	buildSkewed();
+	shardedEngine engine;
+	engine.rebalanceCheckTicks = 0;
+	engine.build(shardCount);
+	engine.run(ticks);
+	double before = imbalance(engine);
+	engine.rebalance();
+	engine.run(ticks);
+	double after = imbalance(engine);
+
+	//the next run measured enough to check on its own and has to recut the neuron count slabs
+	shardedEngine automatic;
+	automatic.rebalanceCheckTicks = ticks;
+	automatic.rebalanceTolerance = 1.1;
+	engine.syncToBrain();
+	automatic.build(shardCount);
+	size_t firstShard = automatic.shard(0).localNeuronRefs.size();
+	automatic.run(ticks / 2);
+	automatic.run(ticks - ticks / 2);
+	automatic.run(ticks);
+	bool recut = automatic.shard(0).localNeuronRefs.size() != firstShard;
+	automatic.syncToBrain();
+	uint64_t got = brainStateChecksum();
+
+	bool ok = after < before && recut && got == expected && rewardValue == expectedReward;
+	std::printf("sharded %zu ways under skewed load: busiest shard %.2fx the mean before rebalance, %.2fx after, run() %s, %s\n",
+		shardCount, before, after, recut ? "recut the slabs" : "DID NOT RECUT", got == expected && rewardValue == expectedReward ? "matches" : "MISMATCH");
+
+	releaseNetwork();
+	rewardValue = 0;
+	deterministicMode = wasDeterministic;
+	return ok;
+}
+
+#if !defined(_WIN32)
+
+//runs the check network for warmup + ticks on the single process engine, then warmup ticks on
+//the single process engine and ticks partitioned over processCount processes with each transport.
+//compares neuron state and the reward tally, and checks the partitioned run left the brain,
+//its queued spikes and rewardValue alone
+bool checkPartitionedRun(uint32_t processCount, uint64_t warmup, uint64_t ticks) {
+	bool wasDeterministic = deterministicMode;
+	deterministicMode = true;
+
+	releaseNetwork();
+	rewardValue = 0;
+	buildCheckNetwork(80, 10, 5);
+	for (uint64_t t = 0; t < warmup + ticks; t++) {
+		tick();
+	}
+	uint64_t expected = brainStateChecksum();
+	int expectedReward = rewardValue;
+
+	bool ok = true;
+	for (transportKind kind : { transportKind::sharedMemory, transportKind::localSocket }) {
+		releaseNetwork();
+		rewardValue = 0;
+		buildCheckNetwork(80, 10, 5);
+		for (uint64_t t = 0; t < warmup; t++) {
+			tick();
+		}
+		uint64_t before = brainStateChecksum();
+		int rewardBefore = rewardValue;
+		size_t queuedBefore;
+		{
+			std::lock_guard<std::mutex> lock(spikeQueueMute);
+			queuedBefore = spikeQueue.size();
+		}
+
+		std::vector<partitionStats> stats;
+		int reward = 0;
+		bool ran = runLocalPartitioned(processCount, ticks, kind, "networkCheck", &stats, &reward);
+		uint64_t sum = 0;
+		for (const partitionStats& rank : stats) {
+			sum += rank.stateChecksum;
+		}
+		bool match = ran && sum == expected && reward == expectedReward;
+
+		//the run must not have touched the brain it was split from
+		size_t queuedAfter;
+		{
+			std::lock_guard<std::mutex> lock(spikeQueueMute);
+			queuedAfter = spikeQueue.size();
+		}
+		bool untouched = brainStateChecksum() == before && queuedAfter == queuedBefore && rewardValue == rewardBefore;
+
+		std::printf("partitioned %s, %u processes, %llu ticks after %llu: %s (reward %d, expected %d)%s\n",
+			kind == transportKind::sharedMemory ? "shared memory" : "socket", processCount,
+			static_cast<unsigned long long>(ticks), static_cast<unsigned long long>(warmup), !ran ? "run failed" : (match ? "matches" : "MISMATCH"),
+			reward, expectedReward, untouched ? "" : ", BRAIN CHANGED");
+		ok &= match && untouched;
+	}
+
+	releaseNetwork();
+	deterministicMode = wasDeterministic;
+	return ok;
+}
+
+#endif
+
+//fixed point engine against the single process engine on the check network, spike train by
+//spike train. it has to match the integer path exactly, the run against the float formula is
+//reported for how far quantizing moves the spike trains, it only fails when nothing fired
+bool checkFixedPoint(uint64_t ticks) {
+	bool wasDeterministic = deterministicMode;
+	deterministicMode = true;
+
+	releaseNetwork();
+	buildCheckNetwork(80, 10, 5);
+	quantizationReport report = validateFixedPoint(ticks, false);
+	printQuantizationReport(report);
+
+	releaseNetwork();
+	buildCheckNetwork(80, 10, 5);
+	quantizationReport floatReport = validateFixedPoint(ticks, true);
+	std::printf("against the float formula: ");
+	printQuantizationReport(floatReport);
+
+	releaseNetwork();
+	deterministicMode = wasDeterministic;
+	return report.mismatchedSpikes == 0 && report.mismatchedStates == 0 && report.referenceSpikes > 0 &&
+		floatReport.referenceSpikes > 0;
+}
+
+//benchmarkPlasticity on the check network, a timing run rather than a check, it only fails
+//when nothing was delivered
+bool runPlasticityBenchmark(uint64_t ticks) {
+	bool wasDeterministic = deterministicMode;
+	deterministicMode = true;
+
+	releaseNetwork();
+	buildCheckNetwork(200, 50, 8);
+	plasticityBenchmark result = benchmarkPlasticity(ticks);
+	printPlasticityBenchmark(result);
+
+	releaseNetwork();
+	deterministicMode = wasDeterministic;
+	return result.plainSpikes > 0 && result.plasticSpikes > 0;
+}
+
+//population engine against the single process engine, lane 0 keeps the default settings and
+//has to end with the brain's strengths and reward tally, lane 1 uses other settings and has to
+//move away
+bool checkPopulation(int episodes, int ticksPerEpisode) {
+	bool wasDeterministic = deterministicMode;
+	deterministicMode = true;
+
+	releaseNetwork();
+	rewardValue = 0;
+	buildCheckNetwork(80, 10, 5);
+
+	std::vector<rewardSettings> settings(2);
+	settings[1].strongAmount = 5;
+	settings[1].youngMultiplier = 40;
+	populationEngine population;
+	population.build(settings);
+
+	for (int episode = 0; episode < episodes; episode++) {
+		for (int t = 0; t < ticksPerEpisode; t++) {
+			tick();
+			population.tick();
+		}
+		bool reward = episode % 3 != 0;
+		calculateReward(reward);
+		population.applyReward(reward);
+	}
+
+	size_t mismatched = 0;
+	size_t moved = 0;
+	for (size_t edge = 0; edge < population.edgeCount(); edge++) {
+		mismatched += population.strength(edge, 0) != brain.synapsePool.at(population.edgeSynapse(edge)).strength;
+		moved += population.strength(edge, 1) != population.strength(edge, 0);
+	}
+	bool ok = mismatched == 0 && population.rewardTally(0) == rewardValue && moved > 0;
+	std::printf("population over %d episodes: %zu of %zu lane 0 strengths differ, tally %d (expected %d), lane 1 moved %zu\n",
+		episodes, mismatched, population.edgeCount(), population.rewardTally(0), rewardValue.load(), moved);
+
+	releaseNetwork();
+	rewardValue = 0;
+	deterministicMode = wasDeterministic;
+	return ok;
+}
+
+//grows a network of pairs of driven neurons two cells apart, far enough apart that only the
+//pairs themselves co-fire. the first pair's midpoint is taken by a quiet neuron so its new neuron
+//has to go to a nearby free cell. checks each pass stops at maxNewNeurons, that every new neuron
+//sits between exactly one pair with all four synapses both ways, and that the quiet neuron was
+//wired to nothing
+bool checkGrowth(int pairs, size_t maxNewNeurons) {
+	bool wasDeterministic = deterministicMode;
+	growthSettings wasGrowth = growth;
+	deterministicMode = true;
+	growth = growthSettings{};
+	growth.interval = 10;
+	growth.minCoFires = 3;
+	growth.maxNewNeurons = maxNewNeurons;
+
+	releaseNetwork();
+	rewardValue = 0;
+	std::vector<std::pair<cellPosition, cellPosition>> driven;
+	for (int i = 0; i < pairs; i++) {
+		cellPosition a{ 20L * i, 0, 0 };
+		cellPosition b{ 20L * i + 2, 0, 0 };
+		createNeuron(a, NeuronType::generic);
+		createNeuron(b, NeuronType::generic);
+		driven.push_back({ a, b });
+	}
+	cellPosition quiet{ 1, 0, 0 };
+	createNeuron(quiet, NeuronType::generic);
+	auto isOriginal = [&quiet](const cellPosition& pos) {
+		bool pairCell = pos.x % 20 == 0 || pos.x % 20 == 2;
+		bool quietCell = pos.x == quiet.x;
+		return pos.y == 0 && pos.z == 0 && (pairCell || quietCell);
+	};
+	brain.genericBank.pool.forEach([&quiet](uint32_t, genericNeuronState& n) {
+		if (n.positionData.Position.x != quiet.x) {
+			n.input = 1000000;
+		}
+	});
+	auto refAt = [](const cellPosition& pos) {
+		return neuronMap.at(computeNeuronPositionHash(pos));
+	};
+
+	//counts the new neurons wired up as asked for, every one of them has to be
+	auto wiredSites = [&]() {
+		size_t wired = 0;
+		size_t grownCount = 0;
+		brain.genericBank.pool.forEach([&](uint32_t index, genericNeuronState& n) {
+			const cellPosition& pos = n.positionData.Position;
+			if (isOriginal(pos)) {
+				return;
+			}
+			grownCount++;
+			uint32_t grownRef = makeNeuronRef(NeuronType::generic, index);
+			int matches = 0;
+			for (const auto& pair : driven) {
+				uint32_t a = refAt(pair.first);
+				uint32_t b = refAt(pair.second);
+				uint32_t links[] = { findSynapse(a, grownRef), findSynapse(grownRef, b), findSynapse(b, grownRef), findSynapse(grownRef, a) };
+				bool all = true;
+				for (uint32_t link : links) {
+					all &= link != noSynapse && brain.synapsePool.at(link).strength == growth.initialStrength;
+				}
+				matches += all ? 1 : 0;
+			}
+			if (matches == 1 && n.childSynapses.read().size() == 2) {
+				wired++;
+			}
+		});
+		return wired == grownCount ? wired : 0;
+	};
+
+	size_t startNeurons = brain.genericBank.pool.liveCount();
+	size_t startSynapses = brain.synapsePool.liveCount();
+	std::vector<size_t> perPass;
+	for (uint64_t t = 0; t < 10 * growth.interval && perPass.size() < 2; t++) {
+		size_t before = growthWorker.grownNeurons;
+		tick();
+		if (growthWorker.grownNeurons != before) {
+			perPass.push_back(growthWorker.grownNeurons - before);
+		}
+	}
+	size_t grownNeurons = brain.genericBank.pool.liveCount() - startNeurons;
+	size_t grownSynapses = brain.synapsePool.liveCount() - startSynapses;
+	size_t wired = wiredSites();
+	size_t capped = std::min<size_t>(maxNewNeurons, pairs);
+	//a grown pair is still not directly connected, so the second pass may pick it again
+	size_t second = capped;
+	uint32_t quietRef = refAt(quiet);
+	bool quietAlone = brain.genericBank.pool.at(neuronRefIndex(quietRef)).childSynapses.read().size() == 0;
+	brain.synapsePool.forEach([&](uint32_t, Synapse& syn) {
+		quietAlone &= syn.childNeuron != quietRef;
+	});
+
+	bool ok = perPass.size() == 2 && perPass[0] == capped && perPass[1] == second &&
+		grownNeurons == capped + second && wired == grownNeurons && grownSynapses == 4 * grownNeurons && quietAlone;
+	std::printf("growth over %d pairs, cap %zu: passes grew %zu and %zu (expected %zu and %zu), %zu of %zu new neurons wired both ways to one pair, %zu synapses, quiet neuron %s\n",
+		pairs, maxNewNeurons, perPass.size() > 0 ? perPass[0] : 0, perPass.size() > 1 ? perPass[1] : 0, capped, second,
+		wired, grownNeurons, grownSynapses, quietAlone ? "untouched" : "WIRED");
+
+	releaseNetwork();
+	rewardValue = 0;
+	growth = wasGrowth;
+	deterministicMode = wasDeterministic;
+	return ok;
+}
+
+//prunes a built network with some synapses pushed to the edge of each removal rule and
+//compares with a serial prune worked out here from the same counters: every adjacency list in
+//order, every neuron's fan in recounted from the lists, and the pool's live slots
+bool checkPruning(int passes) {
+	//at least a few ways even on a single core, unless something pruned before
+	if (pruning.threads == 0) {
+		pruning.threads = std::max(3u, std::max(1u, std::thread::hardware_concurrency()) - 1);
+	}
+	releaseNetwork();
+	buildCheckNetwork(200, 50, 8);
+	randomStream rng{ streamIdFromHash("checkPruning"), 0 };
+	brain.synapsePool.forEach([&rng](uint32_t, Synapse& syn) {
+		int roll = getRandom(0, 9, rng);
+		if (roll == 0) {
+			syn.idleSweeps = static_cast<uint8_t>(pruning.maxIdleSweeps - getRandom(0, 2, rng));
+		}
+		else if (roll == 1) {
+			syn.strength = static_cast<int16_t>(getRandom(-pruning.weakStrength, pruning.weakStrength, rng));
+			syn.age = static_cast<uint8_t>(pruning.minWeakAge);
+			syn.weakSweeps = static_cast<uint8_t>(pruning.maxWeakSweeps - getRandom(0, 2, rng));
+		}
+	});
+
+	auto adjacency = []() {
+		std::map<uint32_t, std::vector<uint32_t>> lists;
+		brain.forEachBank([&lists](auto& bank) {
+			using policy = typename std::decay_t<decltype(bank)>::policy;
+			bank.pool.forEach([&lists](uint32_t index, typename policy::state& n) {
+				adjacencyList::view list = n.childSynapses.read();
+				lists[makeNeuronRef(policy::type, index)].assign(list.begin(), list.end());
+			});
+		});
+		return lists;
+	};
+
+	size_t totalRemoved = 0;
+	size_t mismatches = 0;
+	for (int pass = 0; pass < passes; pass++) {
+
+		//serial prune, same rules as pruneSynapses on copies of the counters
+		std::map<uint32_t, std::vector<uint32_t>> expected = adjacency();
+		std::vector<uint8_t> dead(brain.synapsePool.indexLimit(), 0);
+		size_t expectedRemoved = 0;
+		brain.synapsePool.forEach([&](uint32_t index, Synapse& syn) {
+			int idle = std::min(15, syn.idleSweeps + 1);
+			bool weak = syn.age >= pruning.minWeakAge && std::abs(syn.strength) <= pruning.weakStrength;
+			int weakSweeps = weak ? std::min(15, syn.weakSweeps + 1) : 0;
+			if (idle > pruning.maxIdleSweeps || weakSweeps > pruning.maxWeakSweeps) {
+				dead[index] = 1;
+				expectedRemoved++;
+			}
+		});
+		std::map<uint32_t, uint32_t> expectedFanIn;
+		for (auto& entry : expected) {
+			entry.second.erase(std::remove_if(entry.second.begin(), entry.second.end(), [&dead](uint32_t index) {
+				return dead[index] != 0;
+			}), entry.second.end());
+			for (uint32_t index : entry.second) {
+				expectedFanIn[brain.synapsePool.at(index).childNeuron]++;
+			}
+		}
+		size_t expectedLive = brain.synapsePool.liveCount() - expectedRemoved;
+
+		size_t removed = pruneSynapses();
+		totalRemoved += removed;
+
+		mismatches += removed != expectedRemoved;
+		mismatches += brain.synapsePool.liveCount() != expectedLive;
+		for (uint32_t index = 0; index < dead.size(); index++) {
+			mismatches += dead[index] && brain.synapsePool.isLive(index);
+		}
+		std::map<uint32_t, std::vector<uint32_t>> got = adjacency();
+		mismatches += got != expected;
+		brain.forEachBank([&](auto& bank) {
+			using policy = typename std::decay_t<decltype(bank)>::policy;
+			bank.pool.forEach([&](uint32_t index, typename policy::state& n) {
+				auto found = expectedFanIn.find(makeNeuronRef(policy::type, index));
+				uint32_t fanIn = found == expectedFanIn.end() ? 0 : found->second;
+				mismatches += n.fanIn.load() != fanIn;
+			});
+		});
+	}
+
+	bool ok = mismatches == 0 && totalRemoved > 0;
+	std::printf("pruning over %d passes on %u worker ways: %zu synapses removed, %zu mismatches against the serial prune\n",
+		passes, static_cast<unsigned>(maintenanceWorkers().ways()), totalRemoved, mismatches);
+
+	releaseNetwork();
+	return ok;
+}
+
+//runs the real-time runner with an output that overruns the period for the first overload
+//cycles, so the runner sheds load, then lets it recover. pruning comes due every few ticks.
+//checks no synapse was pruned while maintenance was deferred, that a prune came due during the
+//deferral and that it ran once the runner was back at level 0
+bool checkRealtimeDeferral(uint64_t overload, uint64_t cycles) {
+	bool wasDeterministic = deterministicMode;
+	pruneSettings wasPruning = pruning;
+	deterministicMode = false;
+	pruning.interval = 10;
+
+	releaseNetwork();
+	rewardValue = 0;
+	buildCheckNetwork(40, 10, 5);
+
+	realtimeRunner runner;
+	runner.settings.rateHz = 5000;
+	runner.settings.recoverCycles = 20;
+
+	size_t lastLive = brain.synapsePool.liveCount();
+	uint64_t deferredCycles = 0;
+	uint64_t dueWhileDeferred = 0;
+	uint64_t prunedWhileDeferred = 0;
+	bool ranAfterDeferral = false;
+	realtimeReport report = runner.run(cycles, {}, [&](uint64_t cycle) {
+		if (cycle == 5) {
+			//enough idle synapses that every pass from here on removes some
+			brain.synapsePool.forEach([](uint32_t index, Synapse& syn) {
+				if (index % 4 == 0) {
+					syn.idleSweeps = 15;
+				}
+			});
+		}
+		size_t live = brain.synapsePool.liveCount();
+		if (deferMaintenance) {
+			deferredCycles++;
+			dueWhileDeferred += maintenance.pruneDue;
+			prunedWhileDeferred += live != lastLive;
+		}
+		else if (live < lastLive && dueWhileDeferred > 0) {
+			ranAfterDeferral = true;
+		}
+		lastLive = live;
+		if (cycle < overload) {
+			auto until = std::chrono::steady_clock::now() + std::chrono::microseconds(1000);
+			while (std::chrono::steady_clock::now() < until) {
+			}
+		}
+	});
+
+	//shed at least to level 1 and left the flag clear
+	bool recovered = report.cyclesAtLevel.size() > 1 && report.cyclesAtLevel[1] > 0 && !deferMaintenance;
+	bool ok = deferredCycles > 0 && dueWhileDeferred > 0 && prunedWhileDeferred == 0 && ranAfterDeferral && recovered;
+	std::printf("real time runner, %llu of %llu cycles overloaded: %llu deferred, prune due on %llu of them, %llu pruned while deferred, %s\n",
+		static_cast<unsigned long long>(overload), static_cast<unsigned long long>(cycles),
+		static_cast<unsigned long long>(deferredCycles), static_cast<unsigned long long>(dueWhileDeferred),
+		static_cast<unsigned long long>(prunedWhileDeferred), ranAfterDeferral ? "ran after recovery" : "NEVER RAN AFTER");
+
+	releaseNetwork();
+	rewardValue = 0;
+	pruning = wasPruning;
+	deterministicMode = wasDeterministic;
+	return ok;
+}
+
+//decodeNetpbm on a good P5, a truncated one, headers claiming more than netpbmMaxPixels and
+//one claiming dimensions too large to parse
+bool checkNetpbmDecoder() {
+	auto p5 = [](const std::string& header, size_t payload, uint8_t value) {
+		std::vector<uint8_t> bytes(header.begin(), header.end());
+		bytes.insert(bytes.end(), payload, value);
+		return bytes;
+	};
+	decodedImage image;
+	bool good = decodeNetpbm(p5("P5\n4 3\n255\n", 12, 200), image) &&
+		image.width == 4 && image.height == 3 && image.channels == 1 && image.pixels.size() == 12 && image.pixels[11] == 200;
+	bool truncated = !decodeNetpbm(p5("P5\n4 3\n255\n", 11, 200), image);
+	bool oversized = !decodeNetpbm(p5("P5\n5000 5000\n255\n", 64, 0), image);
+	bool unparsable = !decodeNetpbm(p5("P5\n99999999 99999999\n255\n", 64, 0), image);
+	bool sixteenBit = !decodeNetpbm(p5("P5\n4 3\n65535\n", 12, 0), image);
+
+	bool ok = good && truncated && oversized && unparsable && sixteenBit;
+	std::printf("netpbm decoder: good P5 %s, truncated P5 %s, 5000 x 5000 header %s, unparsable header %s, short 16 bit P5 %s\n",
+		good ? "decoded" : "FAILED", truncated ? "rejected" : "ACCEPTED", oversized ? "rejected" : "ACCEPTED",
+		unparsable ? "rejected" : "ACCEPTED", sixteenBit ? "rejected" : "ACCEPTED");
+	return ok;
+}
+
+#if !defined(_WIN32)
+
+//writes that many small P5 images, one of them truncated, to a temporary directory and reads them
+//through a datasetPipeline with several decoders for two epochs. every good sample has to come
+//out once per epoch in manifest order with its own label and pixels, the bad one skipped
+bool checkDatasetPipeline(size_t files, size_t decodeThreads) {
+	char directory[] = "/tmp/datasetCheckXXXXXX";
+	if (mkdtemp(directory) == nullptr) {
+		std::printf("dataset pipeline: can't make a temporary directory\n");
+		return false;
+	}
+	std::string base = directory;
+	const size_t bad = files / 3;
+	std::vector<std::string> written;
+
+	auto writeFile = [&written](const std::string& path, const std::string& text) {
+		FILE* file = std::fopen(path.c_str(), "wb");
+		if (file == nullptr) {
+			return false;
+		}
+		bool ok = std::fwrite(text.data(), 1, text.size(), file) == text.size();
+		ok &= std::fclose(file) == 0;
+		written.push_back(path);
+		return ok;
+	};
+
+	bool wrote = true;
+	std::string manifest;
+	for (size_t i = 0; i < files; i++) {
+		std::string name = "sample" + std::to_string(i) + ".pgm";
+		std::string image = "P5\n4 4\n255\n" + std::string(i == bad ? 9 : 16, static_cast<char>(i * 5));
+		wrote &= writeFile(base + "/" + name, image);
+		manifest += name + " label " + std::to_string(i) + "\n";
+	}
+	wrote &= writeFile(base + "/manifest.txt", manifest);
+
+	datasetSettings config;
+	config.visualWidth = 4;
+	config.visualHeight = 4;
+	config.buffers = 4;
+	config.readAhead = 8;
+	config.decodeThreads = decodeThreads;
+	config.epochs = 2;
+	config.lockBuffers = false;
+
+	size_t delivered = 0;
+	size_t outOfOrder = 0;
+	datasetStats stats;
+	{
+		datasetPipeline pipeline;
+		wrote &= pipeline.start(base + "/manifest.txt", config);
+		size_t expected = 0;
+		while (trainingSample* sample = pipeline.acquireNext()) {
+			if (expected % files == bad) {
+				expected++;
+			}
+			size_t index = expected % files;
+			bool right = sample->manifestIndex == index && sample->label == "label " + std::to_string(index);
+			for (uint8_t value : sample->visual) {
+				right &= value == static_cast<uint8_t>(index * 5);
+			}
+			outOfOrder += right ? 0 : 1;
+			delivered++;
+			expected++;
+			pipeline.recycle(sample);
+		}
+		stats = pipeline.statistics();
+	}
+
+	for (const std::string& path : written) {
+		std::remove(path.c_str());
+	}
+	rmdir(directory);
+
+	bool ok = wrote && delivered == 2 * (files - 1) && outOfOrder == 0 && stats.decodeFailures == 2;
+	std::printf("dataset pipeline, %zu files over 2 epochs on %zu decoders: %zu delivered (expected %zu), %zu out of order or wrong, %llu failed to decode (expected 2)\n",
+		files, decodeThreads, delivered, 2 * (files - 1), outOfOrder, static_cast<unsigned long long>(stats.decodeFailures));
+	return ok;
+}
+
+#endif
+
+//fills a neuronOctree with random generic and reward neurons, some sharing a cell, and compares
+//box, radius and nearest queries under each type mask with a linear scan of the same entries
+bool checkOctree(size_t neuronCount, int queries) {
+	randomStream rng{ streamIdFromHash("checkOctree"), 0 };
+	neuronOctree tree;
+	std::vector<spatialEntry> all;
+	for (uint32_t i = 0; i < neuronCount; i++) {
+		NeuronType type = getRandom(0, 9, rng) == 0 ? NeuronType::reward : NeuronType::generic;
+		cellPosition pos{ getRandom(-60, 60, rng), getRandom(-60, 60, rng), getRandom(-8, 8, rng) };
+		spatialEntry e{ pos, makeNeuronRef(type, i) };
+		tree.insert(e.position, e.neuronRef);
+		all.push_back(e);
+	}
+
+	auto byRef = [](std::vector<spatialEntry> list) {
+		std::vector<uint32_t> refs;
+		for (const spatialEntry& e : list) {
+			refs.push_back(e.neuronRef);
+		}
+		std::sort(refs.begin(), refs.end());
+		return refs;
+	};
+	auto distanceSquared = [](const cellPosition& a, const cellPosition& b) {
+		double dx = static_cast<double>(a.x - b.x);
+		double dy = static_cast<double>(a.y - b.y);
+		double dz = static_cast<double>(a.z - b.z);
+		return dx * dx + dy * dy + dz * dz;
+	};
+	const uint32_t masks[] = { anyNeuronType, neuronTypeBit(NeuronType::generic), neuronTypeBit(NeuronType::reward) };
+
+	size_t mismatches = 0;
+	size_t found = 0;
+	for (int q = 0; q < queries; q++) {
+		uint32_t mask = masks[q % 3];
+		auto wanted = [mask](const spatialEntry& e) {
+			return (mask & neuronTypeBit(neuronRefType(e.neuronRef))) != 0;
+		};
+		cellPosition center{ getRandom(-80, 80, rng), getRandom(-80, 80, rng), getRandom(-12, 12, rng) };
+
+		cellPosition low = center;
+		cellPosition high{ center.x + getRandom(0, 30, rng), center.y + getRandom(0, 30, rng), center.z + getRandom(0, 6, rng) };
+		std::vector<spatialEntry> box;
+		tree.queryBox(low, high, mask, box);
+		std::vector<spatialEntry> boxScan;
+		for (const spatialEntry& e : all) {
+			const cellPosition& p = e.position;
+			if (wanted(e) && p.x >= low.x && p.x <= high.x && p.y >= low.y && p.y <= high.y && p.z >= low.z && p.z <= high.z) {
+				boxScan.push_back(e);
+			}
+		}
+		mismatches += byRef(box) != byRef(boxScan);
+
+		double radius = getRandom(0, 200, rng) / 10.0;
+		std::vector<spatialEntry> sphere;
+		tree.queryRadius(center, radius, mask, sphere);
+		std::vector<spatialEntry> sphereScan;
+		for (const spatialEntry& e : all) {
+			if (wanted(e) && distanceSquared(e.position, center) <= radius * radius) {
+				sphereScan.push_back(e);
+			}
+		}
+		mismatches += byRef(sphere) != byRef(sphereScan);
+
+		//nearest first, ties by ref, within maxDistance
+		size_t k = static_cast<size_t>(getRandom(1, 40, rng));
+		double maxDistance = q % 2 == 0 ? std::numeric_limits<double>::max() : getRandom(5, 40, rng);
+		std::vector<spatialEntry> closest;
+		tree.nearest(center, k, mask, maxDistance, closest);
+		std::vector<std::pair<double, uint32_t>> ranked;
+		for (const spatialEntry& e : all) {
+			double d = distanceSquared(e.position, center);
+			if (wanted(e) && d <= maxDistance * maxDistance) {
+				ranked.push_back({ d, e.neuronRef });
+			}
+		}
+		std::sort(ranked.begin(), ranked.end());
+		ranked.resize(std::min(k, ranked.size()));
+		bool same = ranked.size() == closest.size();
+		for (size_t i = 0; same && i < ranked.size(); i++) {
+			same = ranked[i].second == closest[i].neuronRef;
+		}
+		mismatches += same ? 0 : 1;
+
+		found += box.size() + sphere.size() + closest.size();
+	}
+
+	bool ok = mismatches == 0 && found > 0 && tree.size() == neuronCount;
+	std::printf("octree over %zu neurons: %d box, radius and nearest queries each, %zu entries found, %zu mismatches against a linear scan\n",
+		neuronCount, queries, found, mismatches);
+	return ok;
+}
+
+#if !defined(_WIN32)
+
+//the check network through a v2 synapse file, spike train by spike train against the fixed point
+//engine: once as build() leaves it mapped, with a resident budget of a few pages so regions are
+//paged out and back in, and once opened again from the file alone with the check network's input
+//injected. then open() has to reject copies of the file with a target past the last neuron, a
+//region table that doesn't tile the neurons and the end cut off
+bool checkOutOfCore(uint64_t ticks) {
+	bool wasDeterministic = deterministicMode;
+	deterministicMode = true;
+
+	char directory[] = "/tmp/outOfCoreCheckXXXXXX";
+	if (mkdtemp(directory) == nullptr) {
+		std::printf("out of core: can't make a temporary directory\n");
+		return false;
+	}
+	std::string path = std::string(directory) + "/network.syn";
+
+	auto compare = [ticks](fixedPointEngine& fixed, outOfCoreEngine& engine, uint64_t& spikes) {
+		uint64_t mismatched = 0;
+		std::vector<uint32_t> expected;
+		std::vector<uint32_t> got;
+		for (uint64_t t = 0; t < ticks; t++) {
+			expected.clear();
+			got.clear();
+			fixed.tick(&expected);
+			engine.tick(&got);
+			std::sort(expected.begin(), expected.end());
+			std::sort(got.begin(), got.end());
+			mismatched += expected != got;
+			spikes += expected.size();
+		}
+		return mismatched;
+	};
+
+	releaseNetwork();
+	buildCheckNetwork(80, 10, 5);
+	fixedPointEngine fixed;
+	fixed.build();
+	outOfCoreEngine engine;
+	engine.settings.regionSide = 8;
+	engine.settings.residentBudgetBytes = 4 * pageSize();
+	engine.settings.evictInterval = 4;
+	bool built = engine.build(path);
+	uint64_t builtSpikes = 0;
+	uint64_t builtMismatches = built ? compare(fixed, engine, builtSpikes) : ticks;
+	outOfCoreStats stats = engine.statistics();
+	size_t regions = engine.regionCount();
+	engine.close();
+
+	releaseNetwork();
+	buildCheckNetwork(80, 10, 5);
+	fixedPointEngine fresh;
+	fresh.build();
+	outOfCoreEngine reopened;
+	bool opened = reopened.open(path);
+	if (opened) {
+		for (uint32_t i = 0; i < reopened.neuronCount(); i++) {
+			brain.visitNeuron(reopened.sourceRef(i), [&](auto& bank, uint32_t index) {
+				reopened.injectInput(i, bank.pool.at(index).input);
+			});
+		}
+	}
+	uint64_t openedSpikes = 0;
+	uint64_t openedMismatches = opened ? compare(fresh, reopened, openedSpikes) : ticks;
+	reopened.close();
+
+	//corrupt copies, each has to be turned away
+	std::vector<uint8_t> bytes;
+	bool read = readWholeFile(path, bytes) && bytes.size() >= sizeof(synapseFileHeader);
+	std::vector<std::string> written = { path };
+	auto corrupted = [&](const std::string& name, const std::function<void(std::vector<uint8_t>&)>& damage) {
+		std::vector<uint8_t> copy = bytes;
+		damage(copy);
+		std::string copyPath = std::string(directory) + "/" + name;
+		FILE* file = std::fopen(copyPath.c_str(), "wb");
+		if (file == nullptr) {
+			return false;
+		}
+		written.push_back(copyPath);
+		bool wrote = std::fwrite(copy.data(), 1, copy.size(), file) == copy.size();
+		wrote &= std::fclose(file) == 0;
+		outOfCoreEngine probe;
+		return wrote && !probe.open(copyPath);
+	};
+	size_t rejected = 0;
+	if (read) {
+		synapseFileHeader header;
+		std::memcpy(&header, bytes.data(), sizeof(header));
+		uint64_t regionTable = header.tableOffset + header.neuronCount * sizeof(synapseFileNeuron);
+		synapseFileRegion first;
+		std::memcpy(&first, bytes.data() + regionTable, sizeof(first));
+		rejected += corrupted("target.syn", [&](std::vector<uint8_t>& copy) {
+			uint32_t past = static_cast<uint32_t>(header.neuronCount);
+			std::memcpy(copy.data() + first.offset, &past, sizeof(past));
+		});
+		rejected += corrupted("tiling.syn", [&](std::vector<uint8_t>& copy) {
+			synapseFileRegion shifted = first;
+			shifted.firstNeuron++;
+			std::memcpy(copy.data() + regionTable, &shifted, sizeof(shifted));
+		});
+		rejected += corrupted("truncated.syn", [](std::vector<uint8_t>& copy) {
+			copy.resize(copy.size() - sizeof(synapseFileRegion));
+		});
+	}
+
+	for (const std::string& file : written) {
+		std::remove(file.c_str());
+	}
+	rmdir(directory);
+
+	bool ok = built && opened && builtMismatches == 0 && openedMismatches == 0 && builtSpikes > 0 &&
+		openedSpikes == builtSpikes && rejected == 3;
+	std::printf("out of core over %llu ticks, %zu regions: built file %llu mismatched ticks, reopened file %llu, %llu spikes each, %llu regions paged out, %zu of 3 corrupt files rejected\n",
+		static_cast<unsigned long long>(ticks), regions, static_cast<unsigned long long>(builtMismatches),
+		static_cast<unsigned long long>(openedMismatches), static_cast<unsigned long long>(builtSpikes),
+		static_cast<unsigned long long>(stats.evictions + stats.droppedMappings), rejected);
+
+	releaseNetwork();
+	deterministicMode = wasDeterministic;
+	return ok;
+}
+
+#endif
+
+//memory report on a larger check network, fails when a synapse costs the target or more
+bool checkMemoryFootprint() {
+	releaseNetwork();
+	buildCheckNetwork(200, 50, 8);
+	memoryReport report = reportMemory();
+	printMemoryReport(report);
+	releaseNetwork();
+	return report.synapseCount > 0 && report.bytesPerSynapse() < synapseBytesTarget;
+}
+
+#if defined(NETWORK_SELF_CHECK)
+
+int main(int argc, char** argv) {
+	std::string check = argc > 1 ? argv[1] : "all";
+	bool ok = true;
+	if (check == "sharded" || check == "all") {
+		ok &= checkShardedHandover(4, 50);
+		ok &= checkShardedRebalance(4, 100);
+	}
+	if (check == "fixedpoint" || check == "all") {
+		ok &= checkFixedPoint(200);
+	}
+	if (check == "population" || check == "all") {
+		ok &= checkPopulation(20, 20);
+	}
+	if (check == "growth" || check == "all") {
+		ok &= checkGrowth(6, 4);
+	}
+	if (check == "pruning" || check == "all") {
+		ok &= checkPruning(4);
+	}
+	if (check == "realtime" || check == "all") {
+		ok &= checkRealtimeDeferral(100, 400);
+	}
+	if (check == "octree" || check == "all") {
+		ok &= checkOctree(5000, 300);
+	}
+	if (check == "dataset" || check == "all") {
+		ok &= checkNetpbmDecoder();
+#if !defined(_WIN32)
+		ok &= checkDatasetPipeline(40, 4);
+#endif
+	}
+#if !defined(_WIN32)
+	if (check == "outofcore" || check == "all") {
+		ok &= checkOutOfCore(200);
+	}
+#endif
+	if (check == "memory" || check == "all") {
+		ok &= checkMemoryFootprint();
+	}
+	//timing, only when asked for by name
+	if (check == "plasticity") {
+		ok &= runPlasticityBenchmark(1000);
+	}
+#if !defined(_WIN32)
+	if (check == "partition" || check == "all") {
+		ok &= checkPartitionedRun(4, 50, 100);
+	}
+#endif
+	return ok ? 0 : 1;
+}
+
+#endif
@@ -0,0 +1,201 @@
+#pragma once
+
+#include <utility>
+#include <vector>
+
+//placement search shared by main.cpp and new.cpp
+//scans cube shells of growing size around a position and picks a random open cell from the
+//first shell that has one. templated on the position type, which needs long x, y and z, on the
+//occupied check and on the random pick, since each file keeps its own of all three
+
+struct gridLayer {
+	int scaleLevel = 1;
+	int scaleAmount = 3;
+	int cubicVolume = 27;
+	int layerSize = 26;
+};
+
+inline void scaleUpGridLayer(gridLayer& layer) {
+
+	int prevVolume = layer.cubicVolume;
+
+	layer.scaleLevel++;
+	layer.scaleAmount += 2;
+	layer.cubicVolume = (layer.scaleAmount * layer.scaleAmount * layer.scaleAmount);
+	layer.layerSize = layer.cubicVolume - prevVolume;
+}
+
+template <typename Position, typename Occupied>
+void mapLayerFace(Position& holder, const gridLayer& layer,
+	const bool& negative, std::vector<Position>& openLayerPositions, const Occupied& occupied) {
+
+	int num = 1;
+	if (negative) {
+		num = -1;
+	}
+
+	int remainingPlaces = (layer.scaleAmount * layer.scaleAmount) - 1;
+	int countRow = layer.scaleAmount - 1;
+	bool reverse = false;
+	while (remainingPlaces > 0) {
+
+		if (countRow > 0) {
+			if (reverse) {
+				holder.y += num;
+			}
+			else {
+				holder.y -= num;
+			}
+			countRow--;
+		}
+		else {
+			holder.z -= num;
+			reverse = !reverse;
+			countRow = layer.scaleAmount;
+		}
+		if (!occupied(holder)) {
+			openLayerPositions.push_back(holder);
+		}
+		remainingPlaces--;
+	}
+}
+
+template <typename Position, typename Occupied>
+void mapLayerRemainder(Position& holder, const gridLayer& layer, std::vector<Position>& openLayerPositions,
+	const Occupied& occupied) {
+
+	int remainingPlaces = (layer.layerSize - (layer.scaleAmount * layer.scaleAmount) * 2) - 1;
+	int countSide = layer.scaleAmount - 1;
+	enum class YZ { minusY, minusZ, plusY, plusZ };
+
+	YZ yz = YZ::minusY;
+
+	while (remainingPlaces > 0) {
+
+		switch (yz) {
+		case YZ::minusY:
+			holder.y -= 1;
+			break;
+		case YZ::minusZ:
+			holder.z -= 1;
+			break;
+		case YZ::plusY:
+			holder.y += 1;
+			break;
+		case YZ::plusZ:
+			holder.z += 1;
+			break;
+		}
+
+		if (!occupied(holder)) {
+			openLayerPositions.push_back(holder);
+		}
+
+		countSide--;
+		remainingPlaces--;
+
+		if (countSide <= 0 && remainingPlaces > 0) {
+			int newValue = static_cast<int>(yz) + 1;
+
+			if (newValue < 4) {
+				yz = static_cast<YZ>(newValue);
+				countSide = layer.scaleAmount - 1;
+				if (yz == YZ::plusZ) {
+					countSide--;
+				}
+			}
+			else {
+				yz = YZ::minusY;
+
+				//move back to +Y, +Z from +Y, (+Z - 1)
+				holder.z += 1;
+				//move to (current X) + 1
+				holder.x += 1;
+
+				if (!occupied(holder)) {
+					openLayerPositions.push_back(holder);
+				}
+
+				remainingPlaces--;
+				countSide = layer.scaleAmount - 1;
+			}
+		}
+	}
+}
+
+template <typename Position>
+struct layerListSuccess {
+	bool success = false;
+	std::vector<Position> layerList;
+};
+
+template <typename Position, typename Occupied>
+layerListSuccess<Position> createLayerList(const Position& pos, const gridLayer& layer, const Occupied& occupied) {
+
+	std::vector<Position> openLayerPositions;
+
+	int toEdge = (layer.scaleAmount - 1) / 2;
+	Position holder = pos;
+	//shift to outmost +X+Y+Z position
+	holder.x += layer.scaleLevel;
+	holder.y += toEdge;
+	holder.z += toEdge;
+
+	if (!occupied(holder)) {
+		openLayerPositions.push_back(holder);
+	}
+
+	//scan entire +X face
+	mapLayerFace(holder, layer, false, openLayerPositions, occupied);
+
+	//move to -X face
+	holder.x -= (layer.scaleLevel * 2);
+
+	if (!occupied(holder)) {
+		openLayerPositions.push_back(holder);
+	}
+
+	//scan entire -X face, position ends at -X+Y+Z
+	mapLayerFace(holder, layer, true, openLayerPositions, occupied);
+
+	//move to -X face + 1
+	holder.x += 1;
+
+	if (!occupied(holder)) {
+		openLayerPositions.push_back(holder);
+	}
+
+	//scan remainder of layer
+	mapLayerRemainder(holder, layer, openLayerPositions, occupied);
+
+	layerListSuccess<Position> success;
+
+	if (openLayerPositions.size() > 0) {
+		success.success = true;
+		success.layerList = std::move(openLayerPositions);
+	}
+
+	return success;
+}
+
+//pick(size) returns an index below size, only called when there is more than one open cell
+template <typename Position, typename Occupied, typename Pick>
+Position findNearbyEmptyPosition(const Position& pos, const Occupied& occupied, const Pick& pick) {
+
+	gridLayer layer;
+
+	layerListSuccess<Position> getNewPosition = createLayerList(pos, layer, occupied);
+
+	//add some limitation later to prevent from scaling beyond max limit of type long in any direction
+	while (!getNewPosition.success) {
+		scaleUpGridLayer(layer);
+		getNewPosition = createLayerList(pos, layer, occupied);
+	}
+
+	int size = static_cast<int>(getNewPosition.layerList.size());
+
+	if (size > 1) {
+		return getNewPosition.layerList[pick(size)];
+	}
+	return getNewPosition.layerList[0];
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+//Philox4x32-10 counter based generator, shared by main.cpp and new.cpp
+//every value is a pure function of (seed, stream, counter), so a stream keyed to a neuron or a
+//position gives the same numbers no matter which thread asks or what was drawn before it.
+//randomStream draws with globalSeed, which each file defines with its own settings
+
+extern uint64_t globalSeed;
+
+struct philoxBlock {
+	uint32_t v[4];
+};
+
+inline philoxBlock philox4x32(uint64_t seed, uint64_t stream, uint64_t counter) {
+	uint32_t c0 = static_cast<uint32_t>(counter);
+	uint32_t c1 = static_cast<uint32_t>(counter >> 32);
+	uint32_t c2 = static_cast<uint32_t>(stream);
+	uint32_t c3 = static_cast<uint32_t>(stream >> 32);
+	uint32_t k0 = static_cast<uint32_t>(seed);
+	uint32_t k1 = static_cast<uint32_t>(seed >> 32);
+
+	for (int round = 0; round < 10; round++) {
+		uint64_t p0 = static_cast<uint64_t>(0xD2511F53u) * c0;
+		uint64_t p1 = static_cast<uint64_t>(0xCD9E8D57u) * c2;
+		uint32_t hi0 = static_cast<uint32_t>(p0 >> 32);
+		uint32_t lo0 = static_cast<uint32_t>(p0);
+		uint32_t hi1 = static_cast<uint32_t>(p1 >> 32);
+		uint32_t lo1 = static_cast<uint32_t>(p1);
+
+		c0 = hi1 ^ c1 ^ k0;
+		c1 = lo1;
+		c2 = hi0 ^ c3 ^ k1;
+		c3 = lo0;
+
+		k0 += 0x9E3779B9u;
+		k1 += 0xBB67AE85u;
+	}
+	return { { c0, c1, c2, c3 } };
+}
+
+//FNV-1a, std::hash is not stable across standard libraries
+inline uint64_t streamIdFromHash(const std::string& hash) {
+	uint64_t h = 1469598103934665603ull;
+	for (unsigned char ch : hash) {
+		h ^= ch;
+		h *= 1099511628211ull;
+	}
+	return h;
+}
+
+struct randomStream {
+	uint64_t stream = 0;
+	uint64_t counter = 0;
+
+	uint32_t next() {
+		return philox4x32(globalSeed, stream, counter++).v[0];
+	}
+};
+
+inline int getRandom(const int& low, const int& high, randomStream& rng) {
+	if (high < low) return 1;
+	uint64_t range = static_cast<uint64_t>(high) - low + 1;
+	//multiply-shift keeps the result in range without a modulo bias worth caring about here
+	return low + static_cast<int>((static_cast<uint64_t>(rng.next()) * range) >> 32);
+}